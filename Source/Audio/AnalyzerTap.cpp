@@ -0,0 +1,53 @@
+#include "AnalyzerTap.h"
+
+AnalyzerTap::AnalyzerTap(int capacity)
+    : fifo(capacity), storage((size_t) capacity, 0.0f)
+{
+}
+
+void AnalyzerTap::setEnabled(bool shouldBeEnabled)
+{
+    // Stale samples from a previous session would show up as a glitch
+    if (shouldBeEnabled && !isEnabled())
+        fifo.reset();
+
+    enabled.store(shouldBeEnabled);
+}
+
+void AnalyzerTap::push(const juce::AudioBuffer<float>& buffer, int numChannels) noexcept
+{
+    numChannels = juce::jmin(numChannels, buffer.getNumChannels(), 2);
+    const int numSamples = buffer.getNumSamples();
+
+    if (numChannels <= 0 || fifo.getFreeSpace() < numSamples)
+        return;
+
+    const float gain = 1.0f / (float) numChannels;
+    const auto scope = fifo.write(numSamples);
+
+    auto copyRange = [&](int start, int size, int sourceOffset)
+    {
+        if (size <= 0)
+            return;
+
+        auto* destination = storage.data() + start;
+        juce::FloatVectorOperations::copyWithMultiply(destination, buffer.getReadPointer(0, sourceOffset), gain, size);
+        if (numChannels > 1)
+            juce::FloatVectorOperations::addWithMultiply(destination, buffer.getReadPointer(1, sourceOffset), gain, size);
+    };
+
+    copyRange(scope.startIndex1, scope.blockSize1, 0);
+    copyRange(scope.startIndex2, scope.blockSize2, scope.blockSize1);
+}
+
+int AnalyzerTap::pull(float* destination, int maxSamples) noexcept
+{
+    const auto scope = fifo.read(juce::jmin(maxSamples, fifo.getNumReady()));
+
+    if (scope.blockSize1 > 0)
+        std::copy(storage.data() + scope.startIndex1, storage.data() + scope.startIndex1 + scope.blockSize1, destination);
+    if (scope.blockSize2 > 0)
+        std::copy(storage.data() + scope.startIndex2, storage.data() + scope.startIndex2 + scope.blockSize2, destination + scope.blockSize1);
+
+    return scope.blockSize1 + scope.blockSize2;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <vector>
+
+// Single-producer, single-consumer ring the audio thread copies its output
+// into for the analyzer. The producer only copies: a mono mix of the first
+// two channels goes into preallocated storage, and if the reader has fallen
+// behind the block is dropped rather than waited for.
+class AnalyzerTap
+{
+public:
+    explicit AnalyzerTap(int capacity = 32768);
+
+    // The audio thread skips the tap entirely while it's disabled
+    void setEnabled(bool shouldBeEnabled);
+    bool isEnabled() const noexcept { return enabled.load(std::memory_order_relaxed); }
+
+    // Audio thread
+    void push(const juce::AudioBuffer<float>& buffer, int numChannels) noexcept;
+
+    // Analysis thread. Returns the number of samples copied.
+    int pull(float* destination, int maxSamples) noexcept;
+    int getNumReady() const noexcept { return fifo.getNumReady(); }
+
+private:
+    juce::AbstractFifo fifo;
+    std::vector<float> storage;
+    std::atomic<bool> enabled{false};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnalyzerTap)
+};
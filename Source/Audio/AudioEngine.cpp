@@ -1,4 +1,7 @@
 #include "AudioEngine.h"
+#include "../Diagnostics/RealtimeAuditor.h"
+#include "../Diagnostics/Tracer.h"
+#include <algorithm>
 
 AudioEngine::AudioEngine() : deviceManager(std::make_unique<juce::AudioDeviceManager>()) {}
 
@@ -7,15 +10,92 @@ AudioEngine::~AudioEngine()
     stop();
 }
 
+void AudioEngine::setNumChannels(int numInputChannels, int numOutputChannels)
+{
+    numInputChannelsToOpen = juce::jmax(0, numInputChannels);
+    numOutputChannelsToOpen = juce::jmax(0, numOutputChannels);
+}
+
+void AudioEngine::setSavedDeviceState(std::unique_ptr<juce::XmlElement> state)
+{
+    savedDeviceState = std::move(state);
+}
+
+std::unique_ptr<juce::XmlElement> AudioEngine::createDeviceState() const
+{
+    if (!isInitialized)
+        return nullptr;
+
+    // createStateXml() only returns something once the setup has been changed
+    // explicitly, so the current setup is written out in the same format
+    if (auto state = deviceManager->createStateXml())
+        return state;
+
+    auto setup = deviceManager->getAudioDeviceSetup();
+    auto state = std::make_unique<juce::XmlElement>("DEVICESETUP");
+
+    state->setAttribute("deviceType", deviceManager->getCurrentAudioDeviceType());
+    state->setAttribute("audioOutputDeviceName", setup.outputDeviceName);
+    state->setAttribute("audioInputDeviceName", setup.inputDeviceName);
+
+    if (setup.sampleRate > 0.0)
+        state->setAttribute("audioDeviceRate", setup.sampleRate);
+    if (setup.bufferSize > 0)
+        state->setAttribute("audioDeviceBufferSize", setup.bufferSize);
+    if (!setup.useDefaultInputChannels)
+        state->setAttribute("audioDeviceInChans", setup.inputChannels.toString(2));
+    if (!setup.useDefaultOutputChannels)
+        state->setAttribute("audioDeviceOutChans", setup.outputChannels.toString(2));
+
+    return state;
+}
+
 void AudioEngine::initialize()
 {
     if (!isInitialized)
     {
-        deviceManager->initialise(2, 2, nullptr, true);
+        juce::String error;
+
+        if (virtualDeviceSettings != nullptr)
+        {
+            // The only device type, so no hardware is ever scanned or opened
+            deviceManager->addAudioDeviceType(std::make_unique<VirtualAudioIODeviceType>(*virtualDeviceSettings));
+
+            juce::AudioDeviceManager::AudioDeviceSetup setup;
+            setup.outputDeviceName = VirtualAudioIODeviceType::deviceName;
+            setup.inputDeviceName = VirtualAudioIODeviceType::deviceName;
+            setup.sampleRate = virtualDeviceSettings->sampleRate;
+            setup.bufferSize = virtualDeviceSettings->bufferSize;
+
+            error = deviceManager->initialise(numInputChannelsToOpen, numOutputChannelsToOpen, nullptr, false, {}, &setup);
+        }
+        else
+        {
+            error = deviceManager->initialise(numInputChannelsToOpen, numOutputChannelsToOpen, savedDeviceState.get(), true);
+        }
+
+        if (error.isNotEmpty())
+            DBG("Audio device initialise: " + error);
+
+        savedDeviceState = nullptr;
         isInitialized = true;
     }
 }
 
+void AudioEngine::useVirtualDevice(const VirtualDeviceSettings& settings)
+{
+    jassert(!isInitialized);
+    virtualDeviceSettings = std::make_unique<VirtualDeviceSettings>(settings);
+}
+
+juce::String AudioEngine::getVirtualDeviceSummary() const
+{
+    if (auto* device = dynamic_cast<VirtualAudioDevice*>(deviceManager->getCurrentAudioDevice()))
+        return device->getSummary();
+
+    return {};
+}
+
 void AudioEngine::start()
 {
     if (isInitialized)
@@ -33,24 +113,73 @@ void AudioEngine::audioDeviceIOCallback(const float** inputChannelData,
                                       int numOutputChannels,
                                       int numSamples)
 {
-    if (currentProcessor != nullptr)
+    Tracer::nameCurrentThread("Audio callback");
+    TRACE_SCOPE_ARG("audioDeviceIOCallback", numSamples);
+    juce::AudioProcessLoadMeasurer::ScopedTimer loadTimer(loadMeasurer, numSamples);
+    const auto callbackStart = juce::Time::getHighResolutionTicks();
+
+    if (currentDevice != nullptr)
+        deviceXRuns.store(currentDevice->getXRunCount());
+
+    const bool recording = flightRecorder.isEnabled();
+    if (recording)
+        flightRecorder.recordInput(inputChannelData, numInputChannels, numSamples);
+
+    // Render-ahead: the plugin runs on its own thread, so only copy out the
+    // result, without taking the lock that thread holds while rendering
+    if (renderAhead != nullptr)
     {
-        // Create a proper buffer with both input and output channels
-        juce::AudioBuffer<float> buffer(juce::jmax(numInputChannels, numOutputChannels), numSamples);
-        
+        renderAhead->read(outputChannelData, numOutputChannels, numSamples);
+
+        juce::AudioBuffer<float> output(outputChannelData, numOutputChannels, numSamples);
+        updateMeters(output, numOutputChannels);
+        if (analyzerTap.isEnabled())
+            analyzerTap.push(output, numOutputChannels);
+        if (recording)
+            flightRecorder.finishBlock(outputChannelData, numOutputChannels, numSamples, callbackStart, deviceXRuns.load());
+        return;
+    }
+
+    const juce::ScopedLock sl(processorLock);
+
+    applyPendingCommands();
+
+    // Latency measurement: record the loopback input before anything else
+    const bool measuringLatency = latencyProbe.isCapturing();
+    if (measuringLatency)
+        latencyProbe.captureInput(inputChannelData, numInputChannels, numSamples);
+
+    const bool hasProcessor = slotProcessors[(size_t) activeSlot] != nullptr || slotProcessors[(size_t) requestedSlot.load()] != nullptr;
+
+    if (hasProcessor)
+    {
+        const int numChannels = juce::jmax(numInputChannels, numOutputChannels);
+
+        // Only happens if the driver delivers more than it announced
+        if (numChannels > processBuffer.getNumChannels() || numSamples > processBuffer.getNumSamples())
+            prepareBuffers(juce::jmax(numChannels, processBuffer.getNumChannels()),
+                           juce::jmax(numSamples, processBuffer.getNumSamples()));
+
+        // Refer to the preallocated storage so nothing is allocated here
+        juce::AudioBuffer<float> buffer(processBuffer.getArrayOfWritePointers(), numChannels, numSamples);
+
         // Clear the buffer first to avoid undefined behavior
         buffer.clear();
-        
+
         // Copy input data to buffer
         for (int i = 0; i < numInputChannels; ++i)
         {
             if (inputChannelData[i] != nullptr && i < buffer.getNumChannels())
                 buffer.copyFrom(i, 0, inputChannelData[i], numSamples);
         }
-        
-        juce::MidiBuffer midiBuffer;
-        currentProcessor->processBlock(buffer, midiBuffer);
-        
+
+        // The probe signal replaces the input so it goes through the plugin
+        if (measuringLatency)
+            latencyProbe.writeProbe(buffer);
+
+        deviceMidi.clear();
+        renderBlock(buffer, deviceMidi, numOutputChannels);
+
         // Copy processed data to output
         for (int i = 0; i < numOutputChannels; ++i)
         {
@@ -72,48 +201,756 @@ void AudioEngine::audioDeviceIOCallback(const float** inputChannelData,
                 juce::FloatVectorOperations::clear(outputChannelData[i], numSamples);
         }
     }
+
+    if (measuringLatency)
+        latencyProbe.finishBlock(outputChannelData, numOutputChannels, numSamples, !hasProcessor);
+
+    // Worst case for the buffer size prober; the load measurer only keeps an average
+    const double elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - callbackStart);
+    const double load = elapsed * deviceSampleRate / juce::jmax(1, numSamples);
+    double previousPeak = peakCallbackLoad.load();
+    while (load > previousPeak && !peakCallbackLoad.compare_exchange_weak(previousPeak, load)) {}
+
+    if (recording)
+        flightRecorder.finishBlock(outputChannelData, numOutputChannels, numSamples, callbackStart, deviceXRuns.load());
+}
+
+void AudioEngine::renderBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi, int numOutputChannels)
+{
+    // Added before re-blocking, so the block adapter keeps the offsets sample-accurate
+    addSequenceMidi(midi, buffer.getNumSamples());
+
+    if (sampleRateAdapter.isActive())
+        sampleRateAdapter.process(buffer, midi, [this](juce::AudioBuffer<float>& block, juce::MidiBuffer& blockMidi)
+                                                { renderSlots(block, blockMidi); });
+    else if (blockAdapter.isActive())
+        blockAdapter.process(buffer, midi, [this](juce::AudioBuffer<float>& block, juce::MidiBuffer& blockMidi)
+                                           { renderSlots(block, blockMidi); });
+    else
+        renderSlots(buffer, midi);
+
+    updateMeters(buffer, numOutputChannels);
+
+    if (analyzerTap.isEnabled())
+        analyzerTap.push(buffer, numOutputChannels);
+}
+
+void AudioEngine::addSequenceMidi(juce::MidiBuffer& midi, int numSamples)
+{
+    if (midiSequence != nullptr)
+        midiSequence->renderNextBlock(midi, numSamples);
+
+    if (releaseSequenceNotes)
+    {
+        for (int channel = 1; channel <= 16; ++channel)
+            midi.addEvent(juce::MidiMessage::allNotesOff(channel), 0);
+        releaseSequenceNotes = false;
+    }
+}
+
+// Render-ahead thread; takes over the audio thread's side of the command queue
+void AudioEngine::renderAheadBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi)
+{
+    const juce::ScopedLock sl(processorLock);
+
+    applyPendingCommands();
+    addSequenceMidi(midi, buffer.getNumSamples());
+
+    if (slotProcessors[(size_t) activeSlot] != nullptr || slotProcessors[(size_t) requestedSlot.load()] != nullptr)
+        renderSlots(buffer, midi);
+    else
+        buffer.clear();
+}
+
+juce::String AudioEngine::enableRenderAhead(const juce::File& sourceFile, double aheadMs, int blockSize)
+{
+    jassert(currentDevice == nullptr); // Call before start()
+
+    auto newRenderAhead = std::make_unique<RenderAhead>([this](juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi)
+                                                        { renderAheadBlock(buffer, midi); },
+                                                        aheadMs, blockSize);
+
+    if (sourceFile != juce::File())
+    {
+        auto error = newRenderAhead->setSourceFile(sourceFile);
+        if (error.isNotEmpty())
+            return error;
+    }
+
+    renderAhead = std::move(newRenderAhead);
+    return {};
+}
+
+juce::String AudioEngine::measureLatency(int outputChannel, int inputChannel,
+                                        std::function<void(const LatencyProbe::Result&)> onComplete)
+{
+    auto* device = currentDevice;
+    if (device == nullptr)
+        return "Audio device is not running";
+
+    if (renderAhead != nullptr)
+        return "Latency can't be measured in render-ahead mode";
+
+    if (!device->getActiveOutputChannels()[outputChannel] || !device->getActiveInputChannels()[inputChannel])
+        return "Output " + juce::String(outputChannel + 1) + " or input " + juce::String(inputChannel + 1) + " is not active";
+
+    // Active channels are delivered to the callback in order, without gaps
+    auto toCallbackIndex = [](const juce::BigInteger& active, int channel)
+    {
+        int index = 0;
+        for (int i = 0; i < channel; ++i)
+            if (active[i])
+                ++index;
+        return index;
+    };
+
+    LatencyProbe::Settings settings;
+    settings.sampleRate = device->getCurrentSampleRate();
+    settings.outputChannel = toCallbackIndex(device->getActiveOutputChannels(), outputChannel);
+    settings.inputChannel = toCallbackIndex(device->getActiveInputChannels(), inputChannel);
+    settings.reported.reportedDeviceSamples = device->getInputLatencyInSamples() + device->getOutputLatencyInSamples();
+    settings.reported.addedSamples = getAddedLatencySamples();
+    settings.reported.bufferSize = device->getCurrentBufferSizeSamples();
+
+    {
+        const juce::ScopedLock sl(processorLock);
+        if (auto* processor = slotProcessors[(size_t) activeSlot])
+            settings.reported.pluginSamples = processor->getLatencySamples();
+    }
+
+    return latencyProbe.start(settings, std::move(onComplete));
+}
+
+void AudioEngine::prepareOffline(double sampleRate, int blockSize, int numChannels)
+{
+    jassert(currentDevice == nullptr); // The device callback would race with us
+
+    const juce::ScopedLock sl(processorLock);
+
+    for (auto* processor : slotProcessors)
+        if (processor != nullptr)
+            processor->releaseResources();
+
+    for (int i = 1; i < multiMonoCopies.size(); ++i)
+        multiMonoCopies.getUnchecked(i)->releaseResources();
+
+    prepareToRender(sampleRate, blockSize, juce::jmax(1, numChannels));
+
+    // Every offline render starts from the same state
+    for (auto* processor : slotProcessors)
+        if (processor != nullptr)
+            processor->reset();
+
+    for (int i = 1; i < multiMonoCopies.size(); ++i)
+        multiMonoCopies.getUnchecked(i)->reset();
+
+    if (midiSequence != nullptr)
+        midiSequence->rewind();
+
+    requestedSlot.store(activeSlot);
+    fadingFromSlot = -1;
+}
+
+void AudioEngine::setMidiSequence(std::unique_ptr<MidiFileSequencer> sequence)
+{
+    if (sequence != nullptr)
+        sequence->prepare(deviceSampleRate);
+
+    {
+        const juce::ScopedLock sl(processorLock);
+        std::swap(midiSequence, sequence);
+        releaseSequenceNotes = midiSequence == nullptr && sequence != nullptr;
+    }
+
+    // The old sequence is freed here, outside the lock
+}
+
+void AudioEngine::processOffline(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi)
+{
+    const juce::ScopedLock sl(processorLock);
+
+    jassert(buffer.getNumSamples() <= processBuffer.getNumSamples());
+
+    applyPendingCommands();
+    renderBlock(buffer, midi, buffer.getNumChannels());
+}
+
+void AudioEngine::renderSlots(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi)
+{
+    const int numSamples = buffer.getNumSamples();
+    const int numChannels = buffer.getNumChannels();
+
+    // Start a crossfade if a different slot was requested and nothing is fading yet
+    const int target = requestedSlot.load();
+    if (target != activeSlot && fadingFromSlot < 0 && slotProcessors[(size_t) target] != nullptr)
+    {
+        if (crossfadeSamples > 0 && slotProcessors[(size_t) activeSlot] != nullptr)
+        {
+            fadingFromSlot = activeSlot;
+            crossfadePosition = 0;
+        }
+        activeSlot = target;
+    }
+
+    // The other slots get their own copy of the input
+    juce::AudioBuffer<float> other(inactiveBuffer.getArrayOfWritePointers(), numChannels, numSamples);
+
+    if (fadingFromSlot >= 0)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+            other.copyFrom(ch, 0, buffer, ch, 0, numSamples);
+        inactiveMidi.clear();
+        inactiveMidi.addEvents(midi, 0, numSamples, 0);
+
+        processSlot(activeSlot, buffer, midi);
+        processSlot(fadingFromSlot, other, inactiveMidi);
+
+        // Linear ramp: both slots run the same material, so the sum stays at unity
+        const int rampLength = juce::jmin(numSamples, crossfadeSamples - crossfadePosition);
+        const float startGain = (float) crossfadePosition / (float) crossfadeSamples;
+        const float endGain = (float) (crossfadePosition + rampLength) / (float) crossfadeSamples;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            buffer.applyGainRamp(ch, 0, rampLength, startGain, endGain);
+            buffer.addFromWithRamp(ch, 0, other.getReadPointer(ch), rampLength, 1.0f - startGain, 1.0f - endGain);
+        }
+
+        crossfadePosition += rampLength;
+        if (crossfadePosition >= crossfadeSamples)
+            fadingFromSlot = -1;
+
+        return;
+    }
+
+    // Decide before processing whether the idle slots fit in the remaining headroom
+    const bool suspendInactive = suspendInactiveSlots.load();
+    const bool runInactive = !suspendInactive
+                          && (!inactiveOnlyWithHeadroom.load()
+                              || loadMeasurer.getLoadAsProportion() < headroomThreshold.load());
+
+    for (int slot = 0; slot < maxSlots; ++slot)
+    {
+        if (slot == activeSlot || slotProcessors[(size_t) slot] == nullptr)
+            continue;
+
+        if (suspendInactive)
+        {
+            slotSuspended[(size_t) slot] = true;
+            slotLoads[(size_t) slot].store(0.0);
+        }
+        else if (runInactive)
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+                other.copyFrom(ch, 0, buffer, ch, 0, numSamples);
+            inactiveMidi.clear();
+            inactiveMidi.addEvents(midi, 0, numSamples, 0);
+
+            processSlot(slot, other, inactiveMidi);
+        }
+    }
+
+    if (slotProcessors[(size_t) activeSlot] != nullptr)
+        processSlot(activeSlot, buffer, midi);
+    else
+        buffer.clear();
+}
+
+void AudioEngine::processSlot(int slot, juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi)
+{
+    auto* processor = slotProcessors[(size_t) slot];
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    // Coming back from suspension: clear old tails first. Hosts reset AUs on the
+    // render thread when seeking, so this is safe here.
+    if (slotSuspended[(size_t) slot])
+    {
+        processor->reset();
+        slotSuspended[(size_t) slot] = false;
+    }
+
+    const bool skip = skipSilence && canSkipBlock(slot, buffer, midi);
+    slotBlocks.fetch_add(1);
+
+    if (skip)
+    {
+        buffer.clear();
+        skippedBlocks.fetch_add(1);
+    }
+    else if (slot == 0 && multiMonoCopies.size() > 1)
+    {
+        multiMonoJob.channelData = buffer.getArrayOfWritePointers();
+        multiMonoJob.numChannels = buffer.getNumChannels();
+        multiMonoJob.numSamples = buffer.getNumSamples();
+        multiMonoJob.spareChannelData = spareChannels.getArrayOfWritePointers();
+        multiMonoJob.midi = &midi;
+
+        workerPool->run(multiMonoJob, multiMonoCopies.size());
+    }
+    else
+    {
+        TRACE_SCOPE_ARG("processBlock", slot);
+        const RealtimeAuditor::ScopedProcessBlock audit;
+
+        if (bypassed)
+            processor->processBlockBypassed(buffer, midi);
+        else
+            processor->processBlock(buffer, midi);
+    }
+
+    // A plugin that still produces sound on silent input keeps running
+    if (skipSilence && !skip)
+        slotSilence[(size_t) slot].outputSilent = isSilent(buffer);
+
+    // Smoothed proportion of the block duration spent in this slot
+    const double elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    const double blockDuration = buffer.getNumSamples() / currentSampleRate;
+    auto& load = slotLoads[(size_t) slot];
+    load.store(load.load() * 0.9 + (elapsed / blockDuration) * 0.1);
+}
+
+// Called before the slot runs: counts the samples of silent input since the
+// last sound or MIDI event. The whole block must be silent, so processing
+// always resumes on the block holding the first non-silent sample.
+bool AudioEngine::canSkipBlock(int slot, const juce::AudioBuffer<float>& buffer, const juce::MidiBuffer& midi)
+{
+    auto& state = slotSilence[(size_t) slot];
+
+    if (!midi.isEmpty() || !isSilent(buffer))
+    {
+        state.silentSamples = 0;
+        return false;
+    }
+
+    if (state.tailSamples < 0)
+        return false;
+
+    const bool tailElapsed = state.silentSamples > state.tailSamples;
+    state.silentSamples += buffer.getNumSamples();
+
+    return tailElapsed && state.outputSilent;
+}
+
+bool AudioEngine::isSilent(const juce::AudioBuffer<float>& buffer) const noexcept
+{
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        if (buffer.getMagnitude(ch, 0, buffer.getNumSamples()) > silenceThreshold)
+            return false;
+
+    return true;
+}
+
+// Message thread: how long a slot must be fed silence before it can be skipped,
+// including the plugin's latency
+juce::int64 AudioEngine::getSilenceTailSamples(juce::AudioProcessor* processor) const
+{
+    if (processor == nullptr)
+        return -1;
+
+    double tailSeconds = processor->getTailLengthSeconds();
+    if (!std::isfinite(tailSeconds) || tailSeconds > 3600.0)
+        return -1;
+
+    if (tailSeconds <= 0.0)
+        tailSeconds = fallbackTailSeconds;
+
+    return (juce::int64) std::ceil(tailSeconds * currentSampleRate) + processor->getLatencySamples();
+}
+
+void AudioEngine::setSilenceSkipping(bool shouldSkip, double tailSeconds, float thresholdDb)
+{
+    jassert(currentDevice == nullptr);
+
+    skipSilence = shouldSkip;
+    fallbackTailSeconds = juce::jmax(0.0, tailSeconds);
+    silenceThreshold = juce::Decibels::decibelsToGain(thresholdDb);
+}
+
+// Runs on the audio thread or one of the workers
+void AudioEngine::processMultiMonoCopy(int index)
+{
+    const int numSamples = multiMonoJob.numSamples;
+    float* channels[2] = {};
+
+    for (int c = 0; c < multiMonoChannels; ++c)
+    {
+        const int ch = index * multiMonoChannels + c;
+
+        if (ch < multiMonoJob.numChannels)
+        {
+            channels[c] = multiMonoJob.channelData[ch];
+        }
+        else
+        {
+            channels[c] = multiMonoJob.spareChannelData[index * multiMonoChannels + c];
+            juce::FloatVectorOperations::clear(channels[c], numSamples);
+        }
+    }
+
+    juce::AudioBuffer<float> view(channels, multiMonoChannels, numSamples);
+
+    auto& midi = *multiMonoMidi.getUnchecked(index);
+    midi.clear();
+    midi.addEvents(*multiMonoJob.midi, 0, numSamples, 0);
+
+    auto* copy = multiMonoCopies.getUnchecked(index);
+    TRACE_SCOPE_ARG("processBlock (multi-mono)", index);
+    const RealtimeAuditor::ScopedProcessBlock audit;
+
+    if (bypassed)
+        copy->processBlockBypassed(view, midi);
+    else
+        copy->processBlock(view, midi);
+}
+
+void AudioEngine::applyPendingCommands()
+{
+    const auto scope = commandFifo.read(commandFifo.getNumReady());
+
+    scope.forEach([this](int index)
+    {
+        const auto& command = commandBuffer[(size_t) index];
+
+        switch (command.type)
+        {
+            case EngineCommand::Type::SetParameter:
+            {
+                auto setParameter = [&command](juce::AudioProcessor* processor)
+                {
+                    const auto& parameters = processor->getParameters();
+                    if (juce::isPositiveAndBelow(command.index, parameters.size()))
+                        parameters[command.index]->setValue(juce::jlimit(0.0f, 1.0f, command.value));
+                };
+
+                int slot = activeSlot;
+                if (command.processor != nullptr)
+                {
+                    const auto found = std::find(slotProcessors.begin(), slotProcessors.end(), command.processor);
+                    if (found == slotProcessors.end())
+                        break;
+
+                    slot = (int) std::distance(slotProcessors.begin(), found);
+                }
+
+                // Multi-mono copies stay linked
+                if (slot == 0 && multiMonoCopies.size() > 1)
+                    for (auto* copy : multiMonoCopies)
+                        setParameter(copy);
+                else if (auto* processor = slotProcessors[(size_t) slot])
+                    setParameter(processor);
+                break;
+            }
+
+            case EngineCommand::Type::SetBypass:
+                bypassed = command.value > 0.5f;
+                break;
+        }
+    });
+}
+
+void AudioEngine::updateMeters(const juce::AudioBuffer<float>& buffer, int numOutputChannels)
+{
+    const int numMeters = juce::jmin(numOutputChannels, buffer.getNumChannels(), maxMeterChannels);
+
+    for (int ch = 0; ch < numMeters; ++ch)
+    {
+        const float peak = buffer.getMagnitude(ch, 0, buffer.getNumSamples());
+        auto& meter = outputPeaks[(size_t) ch];
+
+        // Hold the maximum until the telemetry reader collects it
+        float previous = meter.load();
+        while (peak > previous && !meter.compare_exchange_weak(previous, peak)) {}
+    }
+
+    numOutputChannelsInUse.store(numMeters);
+}
+
+bool AudioEngine::postCommand(const EngineCommand& command)
+{
+    const auto scope = commandFifo.write(1);
+
+    if (scope.blockSize1 + scope.blockSize2 == 0)
+        return false;
+
+    scope.forEach([this, &command](int index) { commandBuffer[(size_t) index] = command; });
+    return true;
+}
+
+float AudioEngine::getOutputPeak(int channel)
+{
+    if (!juce::isPositiveAndBelow(channel, maxMeterChannels))
+        return 0.0f;
+
+    return outputPeaks[(size_t) channel].exchange(0.0f);
+}
+
+juce::String AudioEngine::getCurrentDeviceName() const
+{
+    if (auto* device = deviceManager->getCurrentAudioDevice())
+        return device->getName();
+
+    return {};
+}
+
+double AudioEngine::getCurrentSampleRate() const
+{
+    if (auto* device = deviceManager->getCurrentAudioDevice())
+        return device->getCurrentSampleRate();
+
+    return 0.0;
+}
+
+int AudioEngine::getCurrentBufferSize() const
+{
+    if (auto* device = deviceManager->getCurrentAudioDevice())
+        return device->getCurrentBufferSizeSamples();
+
+    return 0;
+}
+
+juce::Array<int> AudioEngine::getAvailableBufferSizes() const
+{
+    if (auto* device = deviceManager->getCurrentAudioDevice())
+        return device->getAvailableBufferSizes();
+
+    return {};
+}
+
+juce::String AudioEngine::changeDeviceSetup(double sampleRate, int bufferSize, const juce::String& outputDeviceName)
+{
+    if (!isInitialized)
+        return "Audio device not initialized";
+
+    auto setup = deviceManager->getAudioDeviceSetup();
+
+    if (sampleRate > 0.0)
+        setup.sampleRate = sampleRate;
+    if (bufferSize > 0)
+        setup.bufferSize = bufferSize;
+    if (outputDeviceName.isNotEmpty())
+        setup.outputDeviceName = outputDeviceName;
+
+    DBG("Changing audio device setup: " + setup.outputDeviceName + ", " +
+        juce::String(setup.sampleRate) + " Hz, " + juce::String(setup.bufferSize) + " samples");
+
+    // Restarting the device calls audioDeviceAboutToStart(), which prepares the processors again
+    return deviceManager->setAudioDeviceSetup(setup, true);
 }
 
 void AudioEngine::audioDeviceAboutToStart(juce::AudioIODevice* device)
 {
-    if (currentProcessor != nullptr)
-        currentProcessor->prepareToPlay(device->getCurrentSampleRate(),
-                                      device->getCurrentBufferSizeSamples());
+    currentDevice = device;
+
+    flightRecorder.prepare(device->getCurrentSampleRate(), device->getCurrentBufferSizeSamples(),
+                           device->getActiveInputChannels().countNumberOfSetBits(),
+                           device->getActiveOutputChannels().countNumberOfSetBits(), device->getName());
+
+    prepareToRender(device->getCurrentSampleRate(), device->getCurrentBufferSizeSamples(),
+                    juce::jmax(2, device->getActiveInputChannels().countNumberOfSetBits(),
+                                  device->getActiveOutputChannels().countNumberOfSetBits()));
+}
+
+void AudioEngine::prepareToRender(double sampleRate, int bufferSize, int numChannels)
+{
+    deviceSampleRate = sampleRate;
+    currentSampleRate = getProcessingSampleRate(sampleRate);
+    const int processingBlockSize = getProcessingBlockSize(bufferSize, sampleRate);
+
+    loadMeasurer.reset(deviceSampleRate, bufferSize);
+    setCrossfadeLength(crossfadeMs);
+
+    // The sequence is merged with the device MIDI, before any resampling
+    if (midiSequence != nullptr)
+        midiSequence->prepare(deviceSampleRate);
+
+    prepareBuffers(numChannels, juce::jmax(bufferSize, processingBlockSize));
+
+    // The sample rate adapter re-blocks as well, so it replaces the block adapter
+    const bool resample = currentSampleRate != deviceSampleRate;
+    if (resample)
+    {
+        auto error = sampleRateAdapter.prepare(numChannels, deviceSampleRate, currentSampleRate,
+                                               processingBlockSize, bufferSize, resamplerQuality);
+        jassert(error.isEmpty()); // getProcessingSampleRate() checked the ratio
+        juce::ignoreUnused(error);
+        DBG("Sample rate adapter: device " + juce::String(deviceSampleRate) + " Hz, plugin " +
+            juce::String(currentSampleRate) + " Hz in " + juce::String(processingBlockSize) + "-sample blocks, +" +
+            juce::String(sampleRateAdapter.getLatencySamples()) + " samples latency");
+    }
+    else
+    {
+        sampleRateAdapter.release();
+    }
+
+    const bool useBlockAdapter = renderAhead == nullptr && !resample && (internalBlockSize > 0 || coalesceFactor > 1);
+    blockAdapter.prepare(numChannels, useBlockAdapter ? processingBlockSize : 0, bufferSize);
+    addedLatencySamples.store(resample ? sampleRateAdapter.getLatencySamples() : blockAdapter.getLatencySamples());
+
+    if (blockAdapter.isActive())
+        DBG("Block adapter: device " + juce::String(bufferSize) + " samples, plugin " +
+            juce::String(processingBlockSize) + " samples, +" +
+            juce::String(blockAdapter.getLatencySamples()) + " samples latency");
+
+    for (auto* processor : slotProcessors)
+        if (processor != nullptr)
+            processor->prepareToPlay(currentSampleRate, processingBlockSize);
+
+    // Tails are only known once the plugin is prepared
+    for (size_t slot = 0; slot < slotProcessors.size(); ++slot)
+        slotSilence[slot] = { getSilenceTailSamples(slotProcessors[slot]), 0, false };
+    skippedBlocks.store(0);
+    slotBlocks.store(0);
+
+    // Copy 0 is slot 0 and was prepared above
+    for (int i = 1; i < multiMonoCopies.size(); ++i)
+        multiMonoCopies.getUnchecked(i)->prepareToPlay(currentSampleRate, processingBlockSize);
+
+    spareChannels.setSize(juce::jmax(1, multiMonoCopies.size() * multiMonoChannels), juce::jmax(bufferSize, processingBlockSize));
+
+    if (renderAhead != nullptr && currentDevice != nullptr)
+        renderAhead->prepare(numChannels, deviceSampleRate);
 }
 
 void AudioEngine::audioDeviceStopped()
 {
-    if (currentProcessor != nullptr)
-        currentProcessor->releaseResources();
+    currentDevice = nullptr;
+
+    if (renderAhead != nullptr)
+        renderAhead->release();
+
+    for (auto* processor : slotProcessors)
+        if (processor != nullptr)
+            processor->releaseResources();
+
+    for (int i = 1; i < multiMonoCopies.size(); ++i)
+        multiMonoCopies.getUnchecked(i)->releaseResources();
+}
+
+void AudioEngine::prepareBuffers(int numChannels, int numSamples)
+{
+    processBuffer.setSize(numChannels, numSamples, false, false, true);
+    inactiveBuffer.setSize(numChannels, numSamples, false, false, true);
+    inactiveMidi.ensureSize(2048);
+    deviceMidi.ensureSize(2048);
 }
 
 void AudioEngine::setProcessor(juce::AudioProcessor* processor)
 {
-    if (currentProcessor == processor)
+    setSlotProcessor(0, processor);
+}
+
+void AudioEngine::setSlotProcessor(int slot, juce::AudioProcessor* processor)
+{
+    jassert(juce::isPositiveAndBelow(slot, maxSlots));
+
+    if (slotProcessors[(size_t) slot] == processor)
         return;
-        
-    if (currentProcessor != nullptr)
+
+    // Prepare the new processor before the audio thread can see it
+    prepareProcessor(processor);
+    const auto tailSamples = getSilenceTailSamples(processor);
+
+    juce::AudioProcessor* oldProcessor = nullptr;
+    {
+        const juce::ScopedLock sl(processorLock);
+        oldProcessor = slotProcessors[(size_t) slot];
+        slotProcessors[(size_t) slot] = processor;
+        slotSuspended[(size_t) slot] = false;
+        slotSilence[(size_t) slot] = { tailSamples, 0, false };
+
+        if (fadingFromSlot == slot)
+            fadingFromSlot = -1;
+    }
+
+    if (oldProcessor != nullptr)
     {
-        currentProcessor->releaseResources();
+        oldProcessor->releaseResources();
     }
-    
-    currentProcessor = processor;
-    
-    if (currentProcessor != nullptr && isInitialized)
+}
+
+void AudioEngine::setMultiMonoProcessors(const juce::Array<juce::AudioProcessor*>& copies, int channelsPerCopy)
+{
+    jassert(copies.isEmpty() || (channelsPerCopy >= 1 && channelsPerCopy <= 2));
+    channelsPerCopy = juce::jlimit(1, 2, channelsPerCopy);
+
+    for (auto* copy : copies)
+        prepareProcessor(copy, channelsPerCopy);
+
+    // Everything the copies need on the audio thread is allocated up front
+    juce::OwnedArray<juce::MidiBuffer> newMidi;
+    for (int i = 0; i < copies.size(); ++i)
+        newMidi.add(new juce::MidiBuffer())->ensureSize(2048);
+
+    juce::AudioBuffer<float> newSpareChannels(spareChannels.getNumChannels(), spareChannels.getNumSamples());
+    if (auto* device = currentDevice)
+        newSpareChannels.setSize(juce::jmax(1, copies.size() * channelsPerCopy),
+                                 juce::jmax(processBuffer.getNumSamples(), device->getCurrentBufferSizeSamples()));
+
+    // The new workers start before the swap and the old ones stop after it, so
+    // the lock is only held for the pointer swaps. The audio thread takes one copy itself.
+    auto newWorkerPool = std::make_unique<RealtimeWorkerPool>();
+    const int numWorkers = juce::jmin(copies.size() - 1, juce::SystemStats::getNumCpus() - 1);
+    if (numWorkers > 0)
+        newWorkerPool->start(numWorkers);
+
+    auto oldCopies = copies;
+    auto* oldSlotProcessor = slotProcessors[0];
+    const auto tailSamples = getSilenceTailSamples(copies.isEmpty() ? nullptr : copies.getFirst());
+    {
+        const juce::ScopedLock sl(processorLock);
+
+        multiMonoCopies.swapWith(oldCopies);
+        multiMonoChannels = channelsPerCopy;
+        multiMonoMidi.swapWith(newMidi);
+        std::swap(workerPool, newWorkerPool);
+        std::swap(spareChannels, newSpareChannels);
+        slotProcessors[0] = copies.isEmpty() ? nullptr : copies.getFirst();
+        slotSilence[0] = { tailSamples, 0, false };
+    }
+
+    // No batch can be running on the old pool: the audio thread only uses it under the lock
+    newWorkerPool = nullptr;
+
+    if (oldSlotProcessor != nullptr && !copies.contains(oldSlotProcessor) && !oldCopies.contains(oldSlotProcessor))
+        oldSlotProcessor->releaseResources();
+
+    for (auto* oldCopy : oldCopies)
+        if (!copies.contains(oldCopy))
+            oldCopy->releaseResources();
+}
+
+int AudioEngine::getNumActiveChannels() const
+{
+    if (auto* device = deviceManager->getCurrentAudioDevice())
+        return juce::jmax(device->getActiveInputChannels().countNumberOfSetBits(),
+                          device->getActiveOutputChannels().countNumberOfSetBits());
+
+    return 0;
+}
+
+void AudioEngine::prepareProcessor(juce::AudioProcessor* processor, int numChannelsOverride)
+{
+    if (processor != nullptr && isInitialized)
     {
         auto* device = deviceManager->getCurrentAudioDevice();
         if (device != nullptr)
         {
             int numInputChannels = device->getActiveInputChannels().countNumberOfSetBits();
             int numOutputChannels = device->getActiveOutputChannels().countNumberOfSetBits();
-            double sampleRate = device->getCurrentSampleRate();
-            int bufferSize = device->getCurrentBufferSizeSamples();
-            
-            DBG("Configuring processor: " + juce::String(numInputChannels) + " in, " + 
-                juce::String(numOutputChannels) + " out, " + 
-                juce::String(sampleRate) + " Hz, " + 
+            double sampleRate = getProcessingSampleRate(device->getCurrentSampleRate());
+            int bufferSize = getProcessingBlockSize(device->getCurrentBufferSizeSamples(), device->getCurrentSampleRate());
+
+            DBG("Configuring processor: " + juce::String(numInputChannels) + " in, " +
+                juce::String(numOutputChannels) + " out, " +
+                juce::String(sampleRate) + " Hz, " +
                 juce::String(bufferSize) + " samples");
-            
+
+            if (numChannelsOverride > 0)
+            {
+                numInputChannels = numChannelsOverride;
+                numOutputChannels = numChannelsOverride;
+            }
+
             // Verify the processor can handle this configuration
             if (numInputChannels == 0 && numOutputChannels == 0)
             {
@@ -121,12 +958,93 @@ void AudioEngine::setProcessor(juce::AudioProcessor* processor)
                 numInputChannels = 2;  // Fallback to stereo
                 numOutputChannels = 2;
             }
-            
-            currentProcessor->setPlayConfigDetails(numInputChannels,
-                                                numOutputChannels,
-                                                sampleRate,
-                                                bufferSize);
-            currentProcessor->prepareToPlay(sampleRate, bufferSize);
+
+            processor->setPlayConfigDetails(numInputChannels,
+                                            numOutputChannels,
+                                            sampleRate,
+                                            bufferSize);
+            processor->prepareToPlay(sampleRate, bufferSize);
         }
     }
 }
+
+void AudioEngine::setFlightRecorder(double seconds, const juce::File& directory)
+{
+    flightRecorder.setWindow(seconds, directory);
+}
+
+void AudioEngine::setInternalBlockSize(int numSamples)
+{
+    internalBlockSize = juce::jmax(0, numSamples);
+}
+
+void AudioEngine::setBlockCoalescing(int numDeviceBlocks)
+{
+    coalesceFactor = juce::jmax(1, numDeviceBlocks);
+}
+
+void AudioEngine::setInternalSampleRate(double sampleRate, PolyphaseResampler::Quality quality)
+{
+    internalSampleRate = juce::jmax(0.0, sampleRate);
+    resamplerQuality = quality;
+}
+
+double AudioEngine::getProcessingSampleRate(double deviceRate) const
+{
+    if (renderAhead != nullptr || internalSampleRate <= 0.0 || internalSampleRate == deviceRate)
+        return deviceRate;
+
+    auto error = PolyphaseResampler::checkRates(deviceRate, internalSampleRate, resamplerQuality);
+    if (error.isEmpty())
+        error = PolyphaseResampler::checkRates(internalSampleRate, deviceRate, resamplerQuality);
+
+    if (error.isNotEmpty())
+    {
+        DBG("Internal sample rate: " + error + "; running at the device rate");
+        return deviceRate;
+    }
+
+    return internalSampleRate;
+}
+
+int AudioEngine::getProcessingBlockSize(int deviceBufferSize, double deviceRate) const
+{
+    if (renderAhead != nullptr)
+        return renderAhead->getBlockSize();
+
+    if (internalBlockSize > 0)
+        return internalBlockSize;
+
+    // About one plugin block per device block at the internal rate
+    const double ratio = getProcessingSampleRate(deviceRate) / deviceRate;
+    return (int) std::ceil(deviceBufferSize * coalesceFactor * ratio);
+}
+
+void AudioEngine::selectSlot(int slot)
+{
+    if (juce::isPositiveAndBelow(slot, maxSlots))
+        requestedSlot.store(slot);
+}
+
+void AudioEngine::setCrossfadeLength(double milliseconds)
+{
+    crossfadeMs = juce::jmax(0.0, milliseconds);
+
+    const juce::ScopedLock sl(processorLock);
+    crossfadeSamples = juce::roundToInt(crossfadeMs * currentSampleRate / 1000.0);
+    fadingFromSlot = -1;
+}
+
+void AudioEngine::setRunInactiveOnlyWithHeadroom(bool shouldLimit, double loadThreshold)
+{
+    headroomThreshold.store(juce::jlimit(0.0, 1.0, loadThreshold));
+    inactiveOnlyWithHeadroom.store(shouldLimit);
+}
+
+double AudioEngine::getSlotLoad(int slot) const
+{
+    if (!juce::isPositiveAndBelow(slot, maxSlots))
+        return 0.0;
+
+    return slotLoads[(size_t) slot].load();
+}
@@ -1,31 +1,333 @@
 #pragma once
 #include <JuceHeader.h>
+#include "AnalyzerTap.h"
+#include "BlockAdapter.h"
+#include "FlightRecorder.h"
+#include "LatencyProbe.h"
+#include "MidiFileSequencer.h"
+#include "RealtimeWorkerPool.h"
+#include "RenderAhead.h"
+#include "SampleRateAdapter.h"
+#include "VirtualAudioDevice.h"
+#include <array>
+#include <atomic>
+
+// A change sent to the audio thread through AudioEngine::postCommand()
+struct EngineCommand
+{
+    enum class Type
+    {
+        SetParameter, // index = parameter index, value = normalised value
+        SetBypass     // value > 0.5 bypasses the plugin
+    };
+
+    Type type{Type::SetParameter};
+    int index{0};
+    float value{0.0f};
+
+    // SetParameter: the plugin the index belongs to, or nullptr for whichever
+    // slot is audible. A command for a plugin in no slot is dropped.
+    juce::AudioProcessor* processor{nullptr};
+};
 
 class AudioEngine : public juce::AudioIODeviceCallback
 {
 public:
+    // Number of processor slots the engine can hold (slot 0 = A, slot 1 = B,
+    // or slot 0 plus up to seven hot-list plugins)
+    static constexpr int maxSlots = 8;
+
     AudioEngine();
     ~AudioEngine() override;
-    
+
+    // Number of device channels to open; call before initialize()
+    void setNumChannels(int numInputChannels, int numOutputChannels);
+
+    // Device setup to reopen on initialize(), as returned by createDeviceState().
+    // Falls back to the default device if the saved one is unavailable.
+    void setSavedDeviceState(std::unique_ptr<juce::XmlElement> state);
+    std::unique_ptr<juce::XmlElement> createDeviceState() const;
+
+    // Runs on a simulated device instead of audio hardware; call before
+    // initialize(). Any saved device state is ignored.
+    void useVirtualDevice(const VirtualDeviceSettings& settings);
+
+    // Timing summary of the virtual device, or an empty string without one
+    juce::String getVirtualDeviceSummary() const;
+
     void initialize();
     void start();
     void stop();
-    
+
     void audioDeviceIOCallback(const float** inputChannelData,
                              int numInputChannels,
                              float** outputChannelData,
                              int numOutputChannels,
                              int numSamples) override;
-    
+
     void audioDeviceAboutToStart(juce::AudioIODevice* device) override;
     void audioDeviceStopped() override;
-    
+
+    // Sets the processor in slot 0
     void setProcessor(juce::AudioProcessor* processor);
-    
+
+    // Sets the processor in any slot. The processor is prepared before it
+    // is handed to the audio thread, so switching to it later costs nothing.
+    void setSlotProcessor(int slot, juce::AudioProcessor* processor);
+
+    // Multi-mono: copy i processes device channels [i * channelsPerCopy, (i + 1) * channelsPerCopy).
+    // Copy 0 becomes the processor in slot 0; all copies run in parallel on a
+    // pool of realtime worker threads that joins before the callback returns.
+    // Pass an empty array to go back to a single instance.
+    void setMultiMonoProcessors(const juce::Array<juce::AudioProcessor*>& copies, int channelsPerCopy);
+    int getNumWorkerThreads() const { return workerPool->getNumWorkers(); }
+
+    // Larger of the active input and output channel counts of the open device
+    int getNumActiveChannels() const;
+
+    // A/B and hot-list switching: the audio thread crossfades to the requested slot,
+    // starting at the next block boundary
+    void selectSlot(int slot);
+    int getActiveSlot() const { return requestedSlot.load(); }
+    void setCrossfadeLength(double milliseconds);
+
+    // When enabled, slots that are not audible are only processed while the
+    // engine's DSP load stays below the threshold (0..1). Otherwise they are
+    // always processed so their internal state follows the input.
+    void setRunInactiveOnlyWithHeadroom(bool shouldLimit, double loadThreshold);
+
+    // When enabled, slots that are not audible are not processed at all (apart
+    // from fading out), so they cost no CPU. A suspended slot is reset before it
+    // is heard again, so it doesn't replay whatever was left in its buffers.
+    void setSuspendInactiveSlots(bool shouldSuspend) { suspendInactiveSlots.store(shouldSuspend); }
+
+    // Silence skipping: once a slot's input has stayed below thresholdDb with no
+    // MIDI for longer than the plugin's tail, and its output went silent, the
+    // plugin isn't called and the slot outputs silence until the input comes
+    // back. fallbackTailSeconds stands in for plugins that report no tail; an
+    // infinite tail is never skipped. Call before start().
+    void setSilenceSkipping(bool shouldSkip, double fallbackTailSeconds, float thresholdDb);
+    bool isSkippingSilence() const { return skipSilence; }
+
+    // Slot blocks not sent to the plugin, and all slot blocks, since start
+    juce::int64 getSkippedBlockCount() const { return skippedBlocks.load(); }
+    juce::int64 getSlotBlockCount() const { return slotBlocks.load(); }
+
+    // Load of the whole audio callback as a proportion of the block duration
+    double getCpuLoad() const { return loadMeasurer.getLoadAsProportion(); }
+
+    // Highest single-callback load since the previous call (single reader)
+    double getPeakCpuLoad() { return peakCallbackLoad.exchange(0.0); }
+
+    // Load of a single slot's processBlock as a proportion of the block duration
+    double getSlotLoad(int slot) const;
+
+    // Queues a command for the audio thread without locking. Only one thread
+    // may post commands. Returns false if the queue is full.
+    bool postCommand(const EngineCommand& command);
+
+    // Peak level of an output channel since the previous call (single reader)
+    float getOutputPeak(int channel);
+    int getNumOutputChannels() const { return numOutputChannelsInUse.load(); }
+
+    // Output samples for the analyzer; the audio thread only copies into it while enabled
+    AnalyzerTap& getAnalyzerTap() { return analyzerTap; }
+
+    // Xruns reported by the device driver (-1 if the driver can't tell)
+    int getDeviceXRunCount() const { return deviceXRuns.load(); }
+
+    // Callbacks that took longer than the block duration
+    int getEngineXRunCount() const { return loadMeasurer.getXRunCount(); }
+
+    // Keeps the last <seconds> of device input, output and callback timing for
+    // dumping to directory on request or after an overrun (0 = off). Call
+    // before start(); the recorder allocates when the device starts.
+    void setFlightRecorder(double seconds, const juce::File& directory);
+    FlightRecorder& getFlightRecorder() noexcept { return flightRecorder; }
+
+    // Runs the plugin at a fixed internal block size (0 = device block size).
+    // Takes effect the next time the device starts, so call before start().
+    void setInternalBlockSize(int numSamples);
+
+    // Gives the plugin this many device blocks per call (1 = off).
+    // Ignored when a fixed internal block size is set.
+    void setBlockCoalescing(int numDeviceBlocks);
+
+    // Runs the plugin at a fixed sample rate (0 = device rate), resampling to
+    // and from the device in the callback. Falls back to the device rate if the
+    // ratio isn't supported. Takes effect the next time the device starts, so
+    // call before start(). Ignored in render-ahead mode.
+    void setInternalSampleRate(double sampleRate, PolyphaseResampler::Quality quality);
+
+    // Sample rate the plugin runs at; message thread, once the device has started
+    double getPluginSampleRate() const { return currentSampleRate; }
+
+    // Latency added by the block or sample rate adapter, on top of the device and plugin latency
+    int getAddedLatencySamples() const { return addedLatencySamples.load(); }
+
+    // Sample rate and block size the plugin is prepared with for a given device setup
+    double getProcessingSampleRate(double deviceSampleRate) const;
+    int getProcessingBlockSize(int deviceBufferSize, double deviceSampleRate) const;
+
+    // Measures the round-trip latency from an output to an input (which must be
+    // looped back) with the active plugin in the path. Message thread; the
+    // result is delivered on the message thread. Returns an error string if
+    // the measurement couldn't start.
+    juce::String measureLatency(int outputChannel, int inputChannel,
+                                std::function<void(const LatencyProbe::Result&)> onComplete);
+
+    // Plays a loaded MIDI file into the plugin, merged with any incoming MIDI,
+    // both live and offline. Message thread; pass nullptr to stop (held notes
+    // are released). prepareOffline() rewinds it.
+    void setMidiSequence(std::unique_ptr<MidiFileSequencer> sequence);
+
+    // Render-ahead for file-driven playback: the plugin runs on a background
+    // thread aheadMs ahead of the device, in blocks of blockSize, on the looped
+    // source file (if any) and the MIDI sequence, and the callback only copies
+    // the result. Live input is ignored. Call before start(). Returns an error
+    // message, or an empty string on success.
+    juce::String enableRenderAhead(const juce::File& sourceFile, double aheadMs, int blockSize);
+    RenderAhead* getRenderAhead() noexcept { return renderAhead.get(); }
+
+    // Offline rendering through the same processing path as the audio callback,
+    // for when the device isn't running. prepareOffline() prepares and resets
+    // every processor; processOffline() then renders one block of at most
+    // blockSize samples in place.
+    void prepareOffline(double sampleRate, int blockSize, int numChannels);
+    void processOffline(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi);
+
+    // Current device, for choosing a setup; message thread only
+    juce::String getCurrentDeviceName() const;
+    double getCurrentSampleRate() const;
+    int getCurrentBufferSize() const;
+    juce::Array<int> getAvailableBufferSizes() const;
+
+    // Reopens the device with new settings; message thread only.
+    // Pass 0 / an empty name to keep the current value.
+    juce::String changeDeviceSetup(double sampleRate, int bufferSize, const juce::String& outputDeviceName);
+
 private:
+    // numChannelsOverride > 0 prepares the processor with that many inputs and outputs
+    void prepareProcessor(juce::AudioProcessor* processor, int numChannelsOverride = 0);
+    void prepareBuffers(int numChannels, int numSamples);
+    void prepareToRender(double sampleRate, int bufferSize, int numChannels);
+    void renderBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi, int numOutputChannels);
+    void renderSlots(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi);
+    void renderAheadBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi);
+    void addSequenceMidi(juce::MidiBuffer& midi, int numSamples);
+    void processSlot(int slot, juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi);
+    bool canSkipBlock(int slot, const juce::AudioBuffer<float>& buffer, const juce::MidiBuffer& midi);
+    bool isSilent(const juce::AudioBuffer<float>& buffer) const noexcept;
+    juce::int64 getSilenceTailSamples(juce::AudioProcessor* processor) const;
+    void processMultiMonoCopy(int index);
+    void applyPendingCommands();
+    void updateMeters(const juce::AudioBuffer<float>& buffer, int numOutputChannels);
+
     std::unique_ptr<juce::AudioDeviceManager> deviceManager;
-    juce::AudioProcessor* currentProcessor{nullptr};
     bool isInitialized{false};
-    
+    std::unique_ptr<juce::XmlElement> savedDeviceState;
+    std::unique_ptr<VirtualDeviceSettings> virtualDeviceSettings;
+    int numInputChannelsToOpen{2};
+    int numOutputChannelsToOpen{2};
+
+    // Guards the slot pointers; only held briefly while a processor is swapped
+    juce::CriticalSection processorLock;
+    std::array<juce::AudioProcessor*, maxSlots> slotProcessors{};
+
+    // Preallocated so the audio callback never allocates
+    juce::AudioBuffer<float> processBuffer;
+    juce::AudioBuffer<float> inactiveBuffer;
+    juce::MidiBuffer inactiveMidi;
+    juce::MidiBuffer deviceMidi;
+
+    std::unique_ptr<MidiFileSequencer> midiSequence;
+    bool releaseSequenceNotes{false};
+
+    // Crossfade state (audio thread only, apart from the requested slot)
+    std::atomic<int> requestedSlot{0};
+    int activeSlot{0};
+    int fadingFromSlot{-1};
+    int crossfadePosition{0};
+    int crossfadeSamples{0};
+    double crossfadeMs{20.0};
+    double currentSampleRate{44100.0}; // The plugin's rate
+    double deviceSampleRate{44100.0};
+
+    std::atomic<bool> inactiveOnlyWithHeadroom{false};
+    std::atomic<double> headroomThreshold{0.5};
+    std::atomic<bool> suspendInactiveSlots{false};
+    std::array<bool, maxSlots> slotSuspended{}; // Audio thread only
+
+    // Silence skipping; the tails are set on the message thread under the lock
+    struct SilenceState
+    {
+        juce::int64 tailSamples{-1}; // -1 = never skip
+        juce::int64 silentSamples{0};
+        bool outputSilent{false};
+    };
+
+    bool skipSilence{false};
+    double fallbackTailSeconds{2.0};
+    float silenceThreshold{1.0e-6f};
+    std::array<SilenceState, maxSlots> slotSilence{};
+    std::atomic<juce::int64> skippedBlocks{0};
+    std::atomic<juce::int64> slotBlocks{0};
+
+    juce::AudioProcessLoadMeasurer loadMeasurer;
+    std::atomic<double> peakCallbackLoad{0.0};
+    std::array<std::atomic<double>, maxSlots> slotLoads{};
+
+    // Multi-mono copies, dispatched across the worker pool
+    struct MultiMonoJob : public RealtimeWorkerPool::Job
+    {
+        explicit MultiMonoJob(AudioEngine& e) : engine(e) {}
+        void perform(int jobIndex) override { engine.processMultiMonoCopy(jobIndex); }
+
+        AudioEngine& engine;
+        float* const* channelData{nullptr};
+        float* const* spareChannelData{nullptr};
+        int numChannels{0};
+        int numSamples{0};
+        const juce::MidiBuffer* midi{nullptr};
+    };
+
+    juce::Array<juce::AudioProcessor*> multiMonoCopies;
+    int multiMonoChannels{0};
+    juce::OwnedArray<juce::MidiBuffer> multiMonoMidi;
+    juce::AudioBuffer<float> spareChannels; // Stands in for channels the device doesn't have
+    std::unique_ptr<RealtimeWorkerPool> workerPool{std::make_unique<RealtimeWorkerPool>()}; // Swapped, not restarted, under the lock
+    MultiMonoJob multiMonoJob{*this};
+
+    // Fixed-size re-blocking between the device and the plugin
+    BlockAdapter blockAdapter;
+    int internalBlockSize{0};
+    int coalesceFactor{1};
+    std::atomic<int> addedLatencySamples{0};
+
+    // Fixed internal sample rate
+    SampleRateAdapter sampleRateAdapter;
+    double internalSampleRate{0.0};
+    PolyphaseResampler::Quality resamplerQuality{PolyphaseResampler::Quality::Balanced};
+
+    LatencyProbe latencyProbe;
+
+    // Only changed while the device is stopped, so the callback reads it unlocked
+    std::unique_ptr<RenderAhead> renderAhead;
+
+    // Remote control: single producer, the audio thread consumes
+    static constexpr int commandQueueSize = 256;
+    juce::AbstractFifo commandFifo{commandQueueSize};
+    std::array<EngineCommand, commandQueueSize> commandBuffer;
+    bool bypassed{false};
+
+    // Telemetry
+    static constexpr int maxMeterChannels = 32;
+    std::array<std::atomic<float>, maxMeterChannels> outputPeaks{};
+    std::atomic<int> numOutputChannelsInUse{0};
+    AnalyzerTap analyzerTap;
+    FlightRecorder flightRecorder;
+    std::atomic<int> deviceXRuns{-1};
+    juce::AudioIODevice* currentDevice{nullptr};
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioEngine)
 };
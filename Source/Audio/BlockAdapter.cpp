@@ -0,0 +1,72 @@
+#include "BlockAdapter.h"
+
+void BlockAdapter::prepare(int numChannels, int internalBlockSize, int maxDeviceBlockSize)
+{
+    blockSize = juce::jmax(0, internalBlockSize);
+    maxDeviceBlock = juce::jmax(1, maxDeviceBlockSize);
+
+    if (blockSize == 0)
+    {
+        accumulator.setSize(0, 0);
+        outputFifo.setSize(0, 0);
+        return;
+    }
+
+    accumulator.setSize(numChannels, blockSize);
+
+    // Holds the primed block, one rendered block and one device chunk
+    outputFifo.setSize(numChannels, 2 * blockSize + maxDeviceBlock);
+    blockMidi.ensureSize(4096);
+
+    reset();
+}
+
+void BlockAdapter::reset()
+{
+    accumulator.clear();
+    outputFifo.clear();
+    blockMidi.clear();
+    inputFill = 0;
+
+    // One block of silence up front guarantees a full device block can
+    // always be read back, whatever the device block size
+    outputReadPosition = 0;
+    outputReady = blockSize;
+}
+
+void BlockAdapter::writeOutput(const juce::AudioBuffer<float>& block)
+{
+    const int capacity = outputFifo.getNumSamples();
+    const int writePosition = (outputReadPosition + outputReady) % capacity;
+    const int firstPart = juce::jmin(blockSize, capacity - writePosition);
+
+    jassert(outputReady + blockSize <= capacity);
+
+    for (int ch = 0; ch < block.getNumChannels(); ++ch)
+    {
+        outputFifo.copyFrom(ch, writePosition, block, ch, 0, firstPart);
+        if (firstPart < blockSize)
+            outputFifo.copyFrom(ch, 0, block, ch, firstPart, blockSize - firstPart);
+    }
+
+    outputReady += blockSize;
+}
+
+void BlockAdapter::readOutput(juce::AudioBuffer<float>& deviceBuffer, int startSample, int numSamples)
+{
+    const int capacity = outputFifo.getNumSamples();
+    const int numChannels = juce::jmin(deviceBuffer.getNumChannels(), outputFifo.getNumChannels());
+    const int firstPart = juce::jmin(numSamples, capacity - outputReadPosition);
+
+    jassert(outputReady >= numSamples);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        deviceBuffer.copyFrom(ch, startSample, outputFifo, ch, outputReadPosition, firstPart);
+        if (firstPart < numSamples)
+            deviceBuffer.copyFrom(ch, startSample + firstPart, outputFifo, ch, 0, numSamples - firstPart);
+    }
+
+    outputReadPosition = (outputReadPosition + numSamples) % capacity;
+    outputReady -= numSamples;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Re-blocks a stream of arbitrarily sized device blocks into fixed-size
+// blocks for the plugin. Used both to give plugins a steady power-of-two
+// block on drivers with odd or variable buffers, and to coalesce several
+// small device blocks into one larger plugin call.
+//
+// Input is collected until a full block is available, processed, and then
+// read back through an output FIFO primed with one block of silence, so the
+// added latency is always exactly one internal block. All storage is
+// allocated in prepare().
+class BlockAdapter
+{
+public:
+    BlockAdapter() = default;
+
+    void prepare(int numChannels, int internalBlockSize, int maxDeviceBlockSize);
+    void reset();
+
+    bool isActive() const { return blockSize > 0; }
+    int getBlockSize() const { return blockSize; }
+    int getLatencySamples() const { return blockSize; }
+
+    // Processes one device block in place. render(buffer, midi) is called
+    // zero or more times with exactly getBlockSize() samples.
+    template <typename RenderFunction>
+    void process(juce::AudioBuffer<float>& deviceBuffer, juce::MidiBuffer& deviceMidi, RenderFunction&& render)
+    {
+        const int numChannels = juce::jmin(deviceBuffer.getNumChannels(), accumulator.getNumChannels());
+        const int totalSamples = deviceBuffer.getNumSamples();
+
+        // Larger-than-announced device blocks are handled in pieces
+        for (int chunkStart = 0; chunkStart < totalSamples; chunkStart += maxDeviceBlock)
+        {
+            const int chunkLength = juce::jmin(maxDeviceBlock, totalSamples - chunkStart);
+            int position = chunkStart;
+
+            while (position < chunkStart + chunkLength)
+            {
+                const int count = juce::jmin(chunkStart + chunkLength - position, blockSize - inputFill);
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                    accumulator.copyFrom(ch, inputFill, deviceBuffer, ch, position, count);
+
+                blockMidi.addEvents(deviceMidi, position, count, inputFill - position);
+
+                inputFill += count;
+                position += count;
+
+                if (inputFill == blockSize)
+                {
+                    juce::AudioBuffer<float> block(accumulator.getArrayOfWritePointers(), numChannels, blockSize);
+                    render(block, blockMidi);
+                    blockMidi.clear();
+                    writeOutput(block);
+                    inputFill = 0;
+                }
+            }
+
+            readOutput(deviceBuffer, chunkStart, chunkLength);
+        }
+
+        deviceMidi.clear();
+    }
+
+private:
+    void writeOutput(const juce::AudioBuffer<float>& block);
+    void readOutput(juce::AudioBuffer<float>& deviceBuffer, int startSample, int numSamples);
+
+    int blockSize{0};
+    int maxDeviceBlock{0};
+
+    juce::AudioBuffer<float> accumulator;
+    juce::MidiBuffer blockMidi;
+    int inputFill{0};
+
+    juce::AudioBuffer<float> outputFifo;
+    int outputReadPosition{0};
+    int outputReady{0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BlockAdapter)
+};
@@ -0,0 +1,179 @@
+#include "BufferSizeProber.h"
+#include "AudioEngine.h"
+#include "../PluginHost/PluginLoader.h"
+
+BufferSizeProber::BufferSizeProber(AudioEngine& engine, const juce::String& name)
+    : audioEngine(engine), pluginName(name)
+{
+}
+
+BufferSizeProber::~BufferSizeProber()
+{
+    stopTimer();
+}
+
+void BufferSizeProber::start(const Settings& newSettings)
+{
+    settings = newSettings;
+    candidates = audioEngine.getAvailableBufferSizes();
+    candidates.sort();
+    originalSize = audioEngine.getCurrentBufferSize();
+    bestSize = 0;
+    direction = Direction::down;
+
+    startIndex = candidates.indexOf(originalSize);
+    if (startIndex < 0)
+    {
+        // Start from the largest available size not above the current one
+        startIndex = 0;
+        for (int i = 0; i < candidates.size(); ++i)
+            if (candidates[i] <= originalSize)
+                startIndex = i;
+    }
+
+    if (candidates.isEmpty())
+    {
+        PluginLoader::LOG("Buffer probe: device reports no buffer sizes");
+        finish(0);
+        return;
+    }
+
+    PluginLoader::LOG("Buffer probe: " + juce::String(candidates.size()) + " sizes available, starting at "
+                      + juce::String(candidates[startIndex]) + " with "
+                      + juce::String(juce::roundToInt(settings.safetyMargin * 100.0)) + "% safety margin");
+
+    beginStep(startIndex);
+    startTimer(100);
+}
+
+void BufferSizeProber::beginStep(int index)
+{
+    candidateIndex = index;
+    soaking = false;
+    stepStartTime = juce::Time::getMillisecondCounterHiRes();
+
+    auto error = audioEngine.changeDeviceSetup(0.0, candidates[index], {});
+    if (error.isNotEmpty())
+        PluginLoader::LOG("Buffer probe: could not set " + juce::String(candidates[index]) + " samples: " + error);
+}
+
+void BufferSizeProber::timerCallback()
+{
+    const double elapsedSeconds = (juce::Time::getMillisecondCounterHiRes() - stepStartTime) / 1000.0;
+
+    if (!soaking)
+    {
+        if (elapsedSeconds < settings.settleSeconds)
+            return;
+
+        // Settled: start counting from here
+        soaking = true;
+        stepStartTime = juce::Time::getMillisecondCounterHiRes();
+        deviceXRunsAtStart = audioEngine.getDeviceXRunCount();
+        engineXRunsAtStart = audioEngine.getEngineXRunCount();
+        audioEngine.getPeakCpuLoad();
+        peakLoad = 0.0;
+        return;
+    }
+
+    peakLoad = juce::jmax(peakLoad, audioEngine.getPeakCpuLoad());
+
+    if (elapsedSeconds >= settings.soakSeconds)
+        finishStep();
+}
+
+void BufferSizeProber::finishStep()
+{
+    const int size = candidates[candidateIndex];
+    const int deviceXRuns = deviceXRunsAtStart >= 0 ? audioEngine.getDeviceXRunCount() - deviceXRunsAtStart : 0;
+    const int engineXRuns = audioEngine.getEngineXRunCount() - engineXRunsAtStart;
+    const bool actualSizeMatches = audioEngine.getCurrentBufferSize() == size;
+    const bool passed = actualSizeMatches && deviceXRuns == 0 && engineXRuns == 0
+                     && peakLoad < 1.0 - settings.safetyMargin;
+
+    PluginLoader::LOG("Buffer probe: " + juce::String(size) + " samples - peak load "
+                      + juce::String(juce::roundToInt(peakLoad * 100.0)) + "%, xruns "
+                      + juce::String(deviceXRuns) + " device / " + juce::String(engineXRuns) + " engine"
+                      + (actualSizeMatches ? juce::String() : ", device refused this size")
+                      + (passed ? " - stable" : " - unstable"));
+
+    if (direction == Direction::down)
+    {
+        if (passed)
+        {
+            bestSize = size;
+            if (candidateIndex > 0)
+            {
+                beginStep(candidateIndex - 1);
+                return;
+            }
+        }
+        else if (bestSize == 0 && startIndex + 1 < candidates.size())
+        {
+            // The starting size already fails, so look above it instead
+            direction = Direction::up;
+            beginStep(startIndex + 1);
+            return;
+        }
+
+        finish(bestSize);
+        return;
+    }
+
+    if (passed)
+        finish(size);
+    else if (candidateIndex + 1 < candidates.size())
+        beginStep(candidateIndex + 1);
+    else
+        finish(0);
+}
+
+void BufferSizeProber::finish(int bufferSize)
+{
+    stopTimer();
+
+    const int sizeToUse = bufferSize > 0 ? bufferSize : originalSize;
+    if (sizeToUse > 0 && audioEngine.getCurrentBufferSize() != sizeToUse)
+        audioEngine.changeDeviceSetup(0.0, sizeToUse, {});
+
+    if (bufferSize > 0)
+    {
+        if (auto file = openSettingsFile())
+        {
+            file->setValue(getKey(pluginName, audioEngine.getCurrentDeviceName(), audioEngine.getCurrentSampleRate()), bufferSize);
+            file->saveIfNeeded();
+        }
+
+        PluginLoader::LOG("Buffer probe: using " + juce::String(bufferSize) + " samples");
+    }
+    else
+    {
+        PluginLoader::LOG("Buffer probe: no stable buffer size found, keeping " + juce::String(originalSize) + " samples");
+    }
+
+    if (onComplete)
+        onComplete(bufferSize);
+}
+
+int BufferSizeProber::getSavedBufferSize(const juce::String& name, const juce::String& deviceName, double sampleRate)
+{
+    if (auto file = openSettingsFile())
+        return file->getIntValue(getKey(name, deviceName, sampleRate), 0);
+
+    return 0;
+}
+
+std::unique_ptr<juce::PropertiesFile> BufferSizeProber::openSettingsFile()
+{
+    juce::PropertiesFile::Options options;
+    options.storageFormat = juce::PropertiesFile::storeAsXML;
+    options.millisecondsBeforeSaving = -1;
+
+    return std::make_unique<juce::PropertiesFile>(PluginLoader::getDataDirectory().getChildFile("BufferSizes.settings"), options);
+}
+
+juce::String BufferSizeProber::getKey(const juce::String& name, const juce::String& deviceName, double sampleRate)
+{
+    // One entry per plugin, device and sample rate
+    return name + "|" + deviceName + "|" + juce::String(juce::roundToInt(sampleRate));
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <JuceHeader.h>
+#include <functional>
+
+class AudioEngine;
+
+// Finds the smallest stable device buffer size for the loaded plugin.
+//
+// Starting at the current size, the prober walks down the device's available
+// buffer sizes while the plugin runs. Each size is given a short settling
+// time and then a soak period, during which the peak callback load and the
+// driver and engine xruns are watched. A size passes if there were no xruns
+// and the peak load stayed below 1 - safetyMargin. The smallest passing size
+// is applied and saved per plugin, device and sample rate. If the starting
+// size already fails, the prober walks up instead.
+//
+// Runs on the message thread from a timer; the audio thread is untouched
+// apart from the device restarts.
+class BufferSizeProber : private juce::Timer
+{
+public:
+    struct Settings
+    {
+        double safetyMargin{0.3};  // Headroom to keep, as a proportion of the block duration
+        double soakSeconds{5.0};
+        double settleSeconds{0.5}; // Ignored after each device restart
+    };
+
+    BufferSizeProber(AudioEngine& engine, const juce::String& pluginName);
+    ~BufferSizeProber() override;
+
+    void start(const Settings& settings);
+    bool isRunning() const { return isTimerRunning(); }
+
+    // Called with the chosen buffer size, or 0 if no size was stable
+    std::function<void(int bufferSize)> onComplete;
+
+    // Buffer size saved by an earlier probe, or 0
+    static int getSavedBufferSize(const juce::String& pluginName, const juce::String& deviceName, double sampleRate);
+
+private:
+    enum class Direction { down, up };
+
+    void timerCallback() override;
+    void beginStep(int bufferSize);
+    void finishStep();
+    void finish(int bufferSize);
+
+    static std::unique_ptr<juce::PropertiesFile> openSettingsFile();
+    static juce::String getKey(const juce::String& pluginName, const juce::String& deviceName, double sampleRate);
+
+    AudioEngine& audioEngine;
+    juce::String pluginName;
+    Settings settings;
+
+    juce::Array<int> candidates; // Ascending
+    int candidateIndex{-1};
+    int startIndex{-1};
+    int bestSize{0};
+    int originalSize{0};
+    Direction direction{Direction::down};
+
+    double stepStartTime{0.0};
+    bool soaking{false};
+    int deviceXRunsAtStart{0};
+    int engineXRunsAtStart{0};
+    double peakLoad{0.0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BufferSizeProber)
+};
@@ -0,0 +1,253 @@
+#include "FlightRecorder.h"
+#include <algorithm>
+
+FlightRecorder::FlightRecorder()
+    : juce::Thread("Flight recorder")
+{
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    stopThread(10000);
+}
+
+void FlightRecorder::setWindow(double seconds, const juce::File& dumpDirectory)
+{
+    windowSeconds = juce::jmax(0.0, seconds);
+    directory = dumpDirectory;
+}
+
+void FlightRecorder::prepare(double newSampleRate, int bufferSize, int numInputChannels, int numOutputChannels,
+                             const juce::String& newDeviceName)
+{
+    stopThread(10000);
+
+    if (!isEnabled())
+        return;
+
+    sampleRate = newSampleRate;
+    deviceName = newDeviceName;
+    windowSamples = juce::roundToInt(windowSeconds * sampleRate);
+    postTriggerSamples = juce::roundToInt(0.5 * sampleRate);
+
+    // Two seconds of slack between the writer and a dump in progress
+    const int capacity = windowSamples + postTriggerSamples + juce::roundToInt(2.0 * sampleRate);
+    inputRing.setSize(juce::jmax(0, numInputChannels), capacity);
+    outputRing.setSize(juce::jmax(1, numOutputChannels), capacity);
+    inputRing.clear();
+    outputRing.clear();
+
+    // Enough records for callbacks down to half the announced buffer size
+    blocks.assign((size_t) (capacity / juce::jmax(16, bufferSize / 2) + 64), {});
+
+    writtenSamples.store(0);
+    writtenBlocks.store(0);
+    lastDeviceXRuns = -1;
+
+    // The first callbacks often overrun while the device and plugin settle
+    triggerPosition.store(-1);
+    nextTriggerPosition.store(juce::roundToInt(2.0 * sampleRate));
+    dumpRequested.store(false);
+
+    startThread(3); // Below normal: a dump must never compete with the audio threads
+}
+
+void FlightRecorder::copyToRing(juce::AudioBuffer<float>& ring, const float* const* channelData, int numChannels,
+                                int position, int numSamples) noexcept
+{
+    const int firstPart = juce::jmin(numSamples, ring.getNumSamples() - position);
+
+    for (int ch = 0; ch < ring.getNumChannels(); ++ch)
+    {
+        const float* source = ch < numChannels ? channelData[ch] : nullptr;
+
+        if (source == nullptr)
+        {
+            ring.clear(ch, position, firstPart);
+            if (firstPart < numSamples)
+                ring.clear(ch, 0, numSamples - firstPart);
+            continue;
+        }
+
+        ring.copyFrom(ch, position, source, firstPart);
+        if (firstPart < numSamples)
+            ring.copyFrom(ch, 0, source + firstPart, numSamples - firstPart);
+    }
+}
+
+void FlightRecorder::copyFromRing(const juce::AudioBuffer<float>& ring, juce::AudioBuffer<float>& destination,
+                                  int position, int numSamples)
+{
+    const int firstPart = juce::jmin(numSamples, ring.getNumSamples() - position);
+
+    for (int ch = 0; ch < destination.getNumChannels(); ++ch)
+    {
+        destination.copyFrom(ch, 0, ring, ch, position, firstPart);
+        if (firstPart < numSamples)
+            destination.copyFrom(ch, firstPart, ring, ch, 0, numSamples - firstPart);
+    }
+}
+
+void FlightRecorder::recordInput(const float* const* inputChannelData, int numInputChannels, int numSamples) noexcept
+{
+    const int capacity = outputRing.getNumSamples();
+    if (capacity == 0 || numSamples > capacity)
+        return;
+
+    const int position = (int) (writtenSamples.load(std::memory_order_relaxed) % capacity);
+    copyToRing(inputRing, inputChannelData, numInputChannels, position, numSamples);
+}
+
+void FlightRecorder::finishBlock(const float* const* outputChannelData, int numOutputChannels, int numSamples,
+                                 juce::int64 callbackStartTicks, int deviceXRuns) noexcept
+{
+    const int capacity = outputRing.getNumSamples();
+    if (capacity == 0 || numSamples > capacity)
+        return;
+
+    const auto position = writtenSamples.load(std::memory_order_relaxed);
+    copyToRing(outputRing, outputChannelData, numOutputChannels, (int) (position % capacity), numSamples);
+
+    // Same test as the engine's load measurer, plus anything the driver reports
+    const auto durationTicks = juce::Time::getHighResolutionTicks() - callbackStartTicks;
+    const auto blockTicks = juce::Time::secondsToHighResolutionTicks(numSamples / sampleRate);
+    const bool overrun = durationTicks > blockTicks || (lastDeviceXRuns >= 0 && deviceXRuns > lastDeviceXRuns);
+    lastDeviceXRuns = deviceXRuns;
+
+    const auto blockIndex = writtenBlocks.load(std::memory_order_relaxed);
+    auto& record = blocks[(size_t) (blockIndex % (juce::int64) blocks.size())];
+    record.position = position;
+    record.startTicks = callbackStartTicks;
+    record.durationTicks = durationTicks;
+    record.numSamples = numSamples;
+    record.deviceXRuns = deviceXRuns;
+    record.overrun = overrun;
+
+    writtenBlocks.store(blockIndex + 1, std::memory_order_release);
+    writtenSamples.store(position + numSamples, std::memory_order_release);
+
+    if (overrun && triggerPosition.load(std::memory_order_relaxed) < 0
+        && position >= nextTriggerPosition.load(std::memory_order_relaxed))
+        triggerPosition.store(position, std::memory_order_release);
+}
+
+void FlightRecorder::run()
+{
+    while (!threadShouldExit())
+    {
+        wait(50);
+
+        if (dumpRequested.exchange(false))
+            dump(writtenSamples.load(std::memory_order_acquire), "requested");
+
+        // Waits until the audio just after the glitch has been recorded too
+        const auto trigger = triggerPosition.load(std::memory_order_acquire);
+        if (trigger >= 0 && writtenSamples.load(std::memory_order_acquire) >= trigger + postTriggerSamples)
+        {
+            dump(trigger + postTriggerSamples, "overrun");
+            nextTriggerPosition.store(trigger + windowSamples);
+            triggerPosition.store(-1, std::memory_order_release);
+        }
+    }
+}
+
+void FlightRecorder::dump(juce::int64 endPosition, const juce::String& reason)
+{
+    const int capacity = outputRing.getNumSamples();
+    const auto end = juce::jmin(endPosition, writtenSamples.load(std::memory_order_acquire));
+    auto start = juce::jmax((juce::int64) 0, end - windowSamples);
+    const int numSamples = (int) (end - start);
+    if (numSamples <= 0)
+        return;
+
+    juce::AudioBuffer<float> input(inputRing.getNumChannels(), numSamples);
+    juce::AudioBuffer<float> output(outputRing.getNumChannels(), numSamples);
+    copyFromRing(inputRing, input, (int) (start % capacity), numSamples);
+    copyFromRing(outputRing, output, (int) (start % capacity), numSamples);
+
+    std::vector<BlockRecord> window;
+    const auto blockEnd = writtenBlocks.load(std::memory_order_acquire);
+    for (auto i = juce::jmax((juce::int64) 0, blockEnd - (juce::int64) blocks.size()); i < blockEnd; ++i)
+    {
+        const auto& record = blocks[(size_t) (i % (juce::int64) blocks.size())];
+        if (record.position >= start && record.position < end)
+            window.push_back(record);
+    }
+
+    // Only if the copy took longer than the slack: drop whatever the writer reached
+    const auto oldestIntact = writtenSamples.load(std::memory_order_acquire) - capacity;
+    const int skip = (int) juce::jlimit((juce::int64) 0, (juce::int64) numSamples, oldestIntact - start);
+    if (skip > 0)
+    {
+        start += skip;
+        window.erase(std::remove_if(window.begin(), window.end(), [start](const BlockRecord& r) { return r.position < start; }),
+                     window.end());
+    }
+
+    auto folder = directory.getChildFile(juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S") + "-" + reason);
+    if (folder.exists())
+        folder = folder.getNonexistentSibling();
+    if (!folder.createDirectory())
+    {
+        DBG("Flight recorder: could not create " + folder.getFullPathName());
+        return;
+    }
+
+    const juce::AudioBuffer<float> outputWindow(output.getArrayOfWritePointers(), output.getNumChannels(), skip, numSamples - skip);
+    bool written = writeAudio(folder.getChildFile("output.wav"), outputWindow);
+
+    if (input.getNumChannels() > 0)
+    {
+        const juce::AudioBuffer<float> inputWindow(input.getArrayOfWritePointers(), input.getNumChannels(), skip, numSamples - skip);
+        written = writeAudio(folder.getChildFile("input.wav"), inputWindow) && written;
+    }
+
+    // Positions are sample offsets into the audio files
+    juce::String timing;
+    timing << "# " << reason << " dump, " << deviceName << ", " << juce::String(sampleRate, 0) << " Hz, "
+           << juce::String((double) (numSamples - skip) / sampleRate, 2) << " s\n"
+           << "block,time_ms,position,samples,callback_ms,load,device_xruns,overrun\n";
+
+    const auto firstTicks = window.empty() ? (juce::int64) 0 : window.front().startTicks;
+    for (size_t i = 0; i < window.size(); ++i)
+    {
+        const auto& record = window[i];
+        const double callbackMs = juce::Time::highResolutionTicksToSeconds(record.durationTicks) * 1000.0;
+        const double blockMs = record.numSamples * 1000.0 / sampleRate;
+
+        timing << (int) i << ","
+               << juce::String(juce::Time::highResolutionTicksToSeconds(record.startTicks - firstTicks) * 1000.0, 3) << ","
+               << (record.position - start) << "," << record.numSamples << ","
+               << juce::String(callbackMs, 3) << "," << juce::String(callbackMs / blockMs, 3) << ","
+               << record.deviceXRuns << "," << (record.overrun ? 1 : 0) << "\n";
+    }
+
+    written = folder.getChildFile("timing.csv").replaceWithText(timing) && written;
+
+    if (!written)
+        DBG("Flight recorder: could not write everything to " + folder.getFullPathName());
+
+    dumpCount.fetch_add(1);
+    removeOldDumps();
+
+    if (auto callback = onDump)
+        juce::MessageManager::callAsync([callback, folder, reason] { callback(folder, reason); });
+}
+
+bool FlightRecorder::writeAudio(const juce::File& file, const juce::AudioBuffer<float>& audio) const
+{
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(new juce::FileOutputStream(file), sampleRate,
+                                                                        (unsigned int) audio.getNumChannels(), 32, {}, 0));
+    return writer != nullptr && writer->writeFromAudioSampleBuffer(audio, 0, audio.getNumSamples());
+}
+
+void FlightRecorder::removeOldDumps() const
+{
+    auto folders = directory.findChildFiles(juce::File::findDirectories, false);
+    std::sort(folders.begin(), folders.end(), [](const juce::File& a, const juce::File& b)
+              { return a.getFileName() > b.getFileName(); });
+
+    for (int i = numKept; i < folders.size(); ++i)
+        folders.getReference(i).deleteRecursively();
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <vector>
+
+// Keeps the last few seconds of device input, output and per-callback timing
+// (--flight-recorder), so a glitch can be taken away and reproduced offline.
+//
+// The audio thread only copies into rings allocated by prepare(): no locks, no
+// allocation, no waits. A dump, requested from any thread or triggered by an
+// overrun, is written by the recorder's own thread as input.wav, output.wav
+// (32-bit float) and timing.csv in a new folder. An overrun dump waits a moment
+// so the audio right after the glitch is included too.
+//
+// The rings hold a couple of seconds more than the window, so the audio thread
+// can keep writing while a dump copies out without reaching the part being
+// copied. The dump thread polls rather than being signalled, because waking a
+// thread isn't lock-free.
+class FlightRecorder : private juce::Thread
+{
+public:
+    FlightRecorder();
+    ~FlightRecorder() override;
+
+    // Message thread, before the device starts. 0 seconds turns it off.
+    // Dumps go into subfolders of directory; only the newest few are kept.
+    void setWindow(double seconds, const juce::File& directory);
+    bool isEnabled() const noexcept { return windowSeconds > 0.0; }
+
+    // Device start; allocates. Waits for a running dump, then restarts the dump thread.
+    void prepare(double sampleRate, int bufferSize, int numInputChannels, int numOutputChannels,
+                 const juce::String& deviceName);
+
+    // Audio thread, once per callback: the input as it arrived (before the
+    // output is written, in case the driver shares the buffers), then the
+    // output and the callback's timing
+    void recordInput(const float* const* inputChannelData, int numInputChannels, int numSamples) noexcept;
+    void finishBlock(const float* const* outputChannelData, int numOutputChannels, int numSamples,
+                     juce::int64 callbackStartTicks, int deviceXRuns) noexcept;
+
+    // Any thread. Writes the window ending now.
+    void requestDump() noexcept { dumpRequested.store(true); }
+
+    // Called on the message thread after each dump with the folder written and why
+    std::function<void(const juce::File&, const juce::String&)> onDump;
+
+    int getDumpCount() const { return dumpCount.load(); }
+
+private:
+    struct BlockRecord
+    {
+        juce::int64 position{0}; // First sample of the callback, counted since prepare()
+        juce::int64 startTicks{0};
+        juce::int64 durationTicks{0};
+        int numSamples{0};
+        int deviceXRuns{-1};
+        bool overrun{false};
+    };
+
+    void run() override;
+    void dump(juce::int64 endPosition, const juce::String& reason);
+    bool writeAudio(const juce::File& file, const juce::AudioBuffer<float>& audio) const;
+    void removeOldDumps() const;
+
+    static void copyToRing(juce::AudioBuffer<float>& ring, const float* const* channelData, int numChannels,
+                           int position, int numSamples) noexcept;
+    static void copyFromRing(const juce::AudioBuffer<float>& ring, juce::AudioBuffer<float>& destination,
+                             int position, int numSamples);
+
+    static constexpr int numKept = 5;
+
+    // Message thread, only changed while the device is stopped
+    double windowSeconds{0.0};
+    juce::File directory;
+    juce::String deviceName;
+    double sampleRate{44100.0};
+    int windowSamples{0};
+    int postTriggerSamples{0};
+
+    juce::AudioBuffer<float> inputRing;
+    juce::AudioBuffer<float> outputRing;
+    std::vector<BlockRecord> blocks;
+
+    // Audio thread only
+    int lastDeviceXRuns{-1};
+
+    // Published by the audio thread after each block
+    std::atomic<juce::int64> writtenSamples{0};
+    std::atomic<juce::int64> writtenBlocks{0};
+
+    // Overrun trigger: the position of the glitch, -1 when none is pending.
+    // No new one is taken before nextTriggerPosition, so overlapping windows
+    // aren't written twice.
+    std::atomic<juce::int64> triggerPosition{-1};
+    std::atomic<juce::int64> nextTriggerPosition{0};
+    std::atomic<bool> dumpRequested{false};
+    std::atomic<int> dumpCount{0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FlightRecorder)
+};
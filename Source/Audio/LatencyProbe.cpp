@@ -0,0 +1,196 @@
+#include "LatencyProbe.h"
+
+namespace
+{
+    // Below this the correlation peak is indistinguishable from noise,
+    // which usually means the loopback isn't connected
+    constexpr double minimumConfidence = 10.0;
+}
+
+juce::String LatencyProbe::Result::toString() const
+{
+    if (!succeeded)
+        return "Latency measurement failed: " + error;
+
+    const int difference = measuredSamples - getExpectedSamples();
+
+    juce::String text;
+    text << "Round-trip latency: " << measuredSamples << " samples (confidence " << juce::String(confidence, 1) << ")\n"
+         << "Reported: device " << reportedDeviceSamples << " + plugin " << pluginSamples
+         << " + engine " << addedSamples << " = " << getExpectedSamples() << " samples\n"
+         << "Unreported: " << difference << " samples";
+
+    if (bufferSize > 0)
+        text << " (" << juce::String((double) difference / bufferSize, 2) << " buffers of " << bufferSize << ")";
+
+    return text;
+}
+
+LatencyProbe::LatencyProbe() : juce::Thread("Latency probe")
+{
+    // Maximum length sequence from a 15-bit Fibonacci LFSR (x^15 + x^14 + 1)
+    const int length = (1 << sequenceOrder) - 1;
+    sequence.resize((size_t) length);
+
+    juce::uint32 shiftRegister = 1;
+    for (auto& sample : sequence)
+    {
+        const auto bit = ((shiftRegister >> 14) ^ (shiftRegister >> 13)) & 1u;
+        shiftRegister = ((shiftRegister << 1) | bit) & 0x7fffu;
+        sample = (shiftRegister & 1u) != 0 ? sequenceLevel : -sequenceLevel;
+    }
+}
+
+LatencyProbe::~LatencyProbe()
+{
+    stopThread(2000);
+}
+
+juce::String LatencyProbe::start(const Settings& newSettings, std::function<void(const Result&)> onComplete)
+{
+    if (state.load() != idle)
+        return "A latency measurement is already running";
+
+    settings = newSettings;
+    completionCallback = std::move(onComplete);
+
+    recordingLength = (int) sequence.size() + juce::roundToInt(settings.maxLatencySeconds * settings.sampleRate);
+    recording.assign((size_t) recordingLength, 0.0f);
+    position = 0;
+
+    if (!isThreadRunning())
+        startThread();
+
+    // Publishes the buffers to the audio thread
+    state.store(capturing, std::memory_order_release);
+    return {};
+}
+
+void LatencyProbe::captureInput(const float* const* inputChannelData, int numInputChannels, int numSamples) noexcept
+{
+    const int count = juce::jmin(numSamples, recordingLength - position);
+    const int channel = settings.inputChannel;
+
+    if (count <= 0)
+        return;
+
+    if (channel < numInputChannels && inputChannelData[channel] != nullptr)
+        std::copy(inputChannelData[channel], inputChannelData[channel] + count, recording.data() + position);
+}
+
+void LatencyProbe::writeProbe(juce::AudioBuffer<float>& buffer) const noexcept
+{
+    const int numSamples = buffer.getNumSamples();
+    const int count = juce::jlimit(0, numSamples, (int) sequence.size() - position);
+
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    {
+        if (count > 0)
+            buffer.copyFrom(ch, 0, sequence.data() + position, count);
+        if (count < numSamples)
+            buffer.clear(ch, count, numSamples - count);
+    }
+}
+
+void LatencyProbe::finishBlock(float* const* outputChannelData, int numOutputChannels, int numSamples, bool writeProbeDirectly) noexcept
+{
+    for (int ch = 0; ch < numOutputChannels; ++ch)
+    {
+        auto* output = outputChannelData[ch];
+        if (output == nullptr)
+            continue;
+
+        if (ch != settings.outputChannel)
+        {
+            juce::FloatVectorOperations::clear(output, numSamples);
+        }
+        else if (writeProbeDirectly)
+        {
+            const int count = juce::jlimit(0, numSamples, (int) sequence.size() - position);
+            juce::FloatVectorOperations::copy(output, sequence.data() + position, count);
+            juce::FloatVectorOperations::clear(output + count, numSamples - count);
+        }
+    }
+
+    position += numSamples;
+
+    if (position >= recordingLength)
+        state.store(analysing, std::memory_order_release);
+}
+
+void LatencyProbe::run()
+{
+    while (!threadShouldExit())
+    {
+        // Polled rather than signalled, so the audio thread never touches a lock
+        wait(20);
+
+        if (state.load(std::memory_order_acquire) != analysing)
+            continue;
+
+        auto result = analyse();
+        auto callback = completionCallback;
+        state.store(idle);
+
+        if (callback != nullptr)
+            juce::MessageManager::callAsync([callback, result] { callback(result); });
+    }
+}
+
+LatencyProbe::Result LatencyProbe::analyse()
+{
+    Result result = settings.reported;
+
+    const int sequenceLength = (int) sequence.size();
+    const int order = juce::roundToInt(std::ceil(std::log2((double) (recordingLength + sequenceLength))));
+    const int fftSize = 1 << order;
+
+    juce::dsp::FFT fft(order);
+    std::vector<float> recorded((size_t) (2 * fftSize), 0.0f);
+    std::vector<float> reference((size_t) (2 * fftSize), 0.0f);
+
+    std::copy(recording.begin(), recording.end(), recorded.begin());
+    std::copy(sequence.begin(), sequence.end(), reference.begin());
+
+    fft.performRealOnlyForwardTransform(recorded.data());
+    fft.performRealOnlyForwardTransform(reference.data());
+
+    // Cross-correlation: recorded * conj(reference), back in the time domain
+    auto* recordedBins = reinterpret_cast<std::complex<float>*>(recorded.data());
+    auto* referenceBins = reinterpret_cast<std::complex<float>*>(reference.data());
+
+    for (int bin = 0; bin < fftSize; ++bin)
+        recordedBins[bin] *= std::conj(referenceBins[bin]);
+
+    fft.performRealOnlyInverseTransform(recorded.data());
+
+    // Only non-negative lags that leave the whole sequence inside the recording
+    const int maxLag = recordingLength - sequenceLength;
+    int peakLag = 0;
+    float peak = 0.0f;
+    double sumOfSquares = 0.0;
+
+    for (int lag = 0; lag <= maxLag; ++lag)
+    {
+        const float value = std::abs(recorded[(size_t) lag]);
+        sumOfSquares += (double) value * value;
+
+        if (value > peak)
+        {
+            peak = value;
+            peakLag = lag;
+        }
+    }
+
+    const double rms = std::sqrt(sumOfSquares / (maxLag + 1));
+    result.confidence = rms > 0.0 ? peak / rms : 0.0;
+    result.measuredSamples = peakLag;
+    result.succeeded = result.confidence >= minimumConfidence;
+
+    if (!result.succeeded)
+        result.error = "no clear correlation peak (confidence " + juce::String(result.confidence, 1)
+                     + "), check that output " + juce::String(settings.outputChannel + 1)
+                     + " is looped back to input " + juce::String(settings.inputChannel + 1);
+
+    return result;
+}
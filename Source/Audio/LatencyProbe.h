@@ -0,0 +1,84 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+// Round-trip latency measurement through a loopback (hardware cable or a
+// software loopback driver).
+//
+// While a measurement runs, the engine replaces its input with a maximum
+// length sequence, processes it as usual, sends the result to one output
+// and records one device input. A background thread then cross-correlates
+// the recording with the sequence using an FFT; the peak is the latency of
+// the whole chain: driver, device, plugin and any buffering the engine adds.
+//
+// The audio thread only copies samples; buffers are allocated in start().
+class LatencyProbe : private juce::Thread
+{
+public:
+    struct Result
+    {
+        bool succeeded{false};
+        juce::String error;
+
+        int measuredSamples{0};
+        double confidence{0.0}; // Correlation peak over its RMS
+
+        // What the rest of the system claims
+        int reportedDeviceSamples{0}; // Device input + output latency
+        int pluginSamples{0};         // getLatencySamples() of the active plugin
+        int addedSamples{0};          // Engine block adapter
+        int bufferSize{0};
+
+        int getExpectedSamples() const { return reportedDeviceSamples + pluginSamples + addedSamples; }
+        juce::String toString() const;
+    };
+
+    struct Settings
+    {
+        double sampleRate{44100.0};
+        int inputChannel{0};
+        int outputChannel{0};
+        double maxLatencySeconds{1.0};
+
+        Result reported; // Reported latencies, copied into the result
+    };
+
+    LatencyProbe();
+    ~LatencyProbe() override;
+
+    // Message thread. onComplete is called on the message thread.
+    // Returns an error if a measurement is already running.
+    juce::String start(const Settings& settings, std::function<void(const Result&)> onComplete);
+
+    bool isCapturing() const noexcept { return state.load(std::memory_order_acquire) == capturing; }
+
+    // Audio thread, in this order within a callback while isCapturing()
+    void captureInput(const float* const* inputChannelData, int numInputChannels, int numSamples) noexcept;
+    void writeProbe(juce::AudioBuffer<float>& buffer) const noexcept;
+
+    // Silences every output but the probe's; writes the probe straight to it
+    // if nothing processed it (no plugin loaded)
+    void finishBlock(float* const* outputChannelData, int numOutputChannels, int numSamples, bool writeProbeDirectly) noexcept;
+
+private:
+    enum State { idle, capturing, analysing };
+
+    void run() override;
+    Result analyse();
+
+    static constexpr int sequenceOrder = 15; // 32767 samples
+    static constexpr float sequenceLevel = 0.25f;
+
+    std::vector<float> sequence;
+    std::vector<float> recording;
+    int position{0};
+    int recordingLength{0};
+
+    Settings settings;
+    std::function<void(const Result&)> completionCallback;
+    std::atomic<int> state{idle};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LatencyProbe)
+};
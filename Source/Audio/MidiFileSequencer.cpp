@@ -0,0 +1,102 @@
+#include "MidiFileSequencer.h"
+#include <algorithm>
+
+juce::String MidiFileSequencer::load(const juce::File& file)
+{
+    juce::FileInputStream stream(file);
+    if (!stream.openedOk())
+        return "Could not open " + file.getFullPathName();
+
+    juce::MidiFile midiFile;
+    if (!midiFile.readFrom(stream))
+        return file.getFileName() + " is not a valid MIDI file";
+
+    // Applies the tempo map (and SMPTE timing) to every track
+    midiFile.convertTimestampTicksToSeconds();
+
+    std::vector<Event> newEvents;
+
+    for (int track = 0; track < midiFile.getNumTracks(); ++track)
+    {
+        const auto& sequence = *midiFile.getTrack(track);
+
+        for (int i = 0; i < sequence.getNumEvents(); ++i)
+        {
+            const auto& message = sequence.getEventPointer(i)->message;
+            const int size = message.getRawDataSize();
+
+            if (message.isMetaEvent() || message.isSysEx() || size <= 0 || size > 3)
+                continue;
+
+            Event event{};
+            event.seconds = message.getTimeStamp();
+            event.size = (juce::uint8) size;
+            std::copy(message.getRawData(), message.getRawData() + size, event.data);
+            newEvents.push_back(event);
+        }
+    }
+
+    if (newEvents.empty())
+        return file.getFileName() + " has no notes or controller events";
+
+    // Stable, so events at the same time keep their order within a track
+    std::stable_sort(newEvents.begin(), newEvents.end(),
+                     [](const Event& a, const Event& b) { return a.seconds < b.seconds; });
+
+    events = std::move(newEvents);
+    fileName = file.getFileName();
+    lengthSeconds = events.back().seconds;
+    lengthSamples = 0;
+    rewind();
+
+    return {};
+}
+
+void MidiFileSequencer::prepare(double sampleRate)
+{
+    for (auto& event : events)
+        event.sample = (juce::int64) (event.seconds * sampleRate + 0.5);
+
+    // One past the last event, so it is played before a loop restarts
+    lengthSamples = events.empty() ? 0 : events.back().sample + 1;
+    rewind();
+}
+
+void MidiFileSequencer::rewind() noexcept
+{
+    cursor = 0;
+    position = 0;
+}
+
+void MidiFileSequencer::renderNextBlock(juce::MidiBuffer& midi, int numSamples) noexcept
+{
+    int offset = 0;
+
+    while (offset < numSamples)
+    {
+        const bool loopsInThisBlock = looping && lengthSamples > 0;
+        const int count = loopsInThisBlock ? (int) juce::jmin((juce::int64) (numSamples - offset), lengthSamples - position)
+                                           : numSamples - offset;
+        const auto end = position + count;
+
+        // Events are sorted, so this only ever moves forward
+        while (cursor < events.size() && events[cursor].sample < end)
+        {
+            const auto& event = events[cursor++];
+            midi.addEvent(event.data, event.size, offset + (int) (event.sample - position));
+        }
+
+        position = end;
+        offset += count;
+
+        if (loopsInThisBlock && position >= lengthSamples)
+        {
+            // Nothing held over the loop point keeps sounding
+            const int lastSample = juce::jmax(0, offset - 1);
+            for (int channel = 1; channel <= 16; ++channel)
+                midi.addEvent(juce::MidiMessage::allNotesOff(channel), lastSample);
+
+            rewind();
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+
+// Plays a Standard MIDI File into the engine, for rendering and benchmarking
+// instrument plugins with the same input every time.
+//
+// load() parses the whole file up front: every track is merged into one
+// time-sorted array of short messages, with times taken through the file's
+// tempo map. prepare() turns those times into sample positions, and
+// renderNextBlock() then only advances a cursor through the array, so the
+// audio thread never searches, sorts or allocates. System exclusive and meta
+// events are not played.
+class MidiFileSequencer
+{
+public:
+    MidiFileSequencer() = default;
+
+    // Message thread. Returns an error message, or an empty string on success.
+    juce::String load(const juce::File& file);
+
+    // Converts event times for this sample rate and rewinds. Not concurrent
+    // with renderNextBlock().
+    void prepare(double sampleRate);
+    void rewind() noexcept;
+
+    // Restart from the beginning when the end is reached (default on)
+    void setLooping(bool shouldLoop) noexcept { looping = shouldLoop; }
+
+    // Audio thread. Adds the events that fall inside the next numSamples to
+    // midi, at their offsets within the block.
+    void renderNextBlock(juce::MidiBuffer& midi, int numSamples) noexcept;
+
+    // True once a non-looping sequence has played its last event
+    bool hasFinished() const noexcept { return !looping && cursor >= events.size(); }
+
+    juce::String getFileName() const { return fileName; }
+    int getNumEvents() const noexcept { return (int) events.size(); }
+    double getLengthInSeconds() const noexcept { return lengthSeconds; }
+    juce::int64 getLengthInSamples() const noexcept { return lengthSamples; }
+
+private:
+    struct Event
+    {
+        juce::int64 sample;
+        double seconds;
+        juce::uint8 data[3];
+        juce::uint8 size;
+    };
+
+    std::vector<Event> events;
+    juce::String fileName;
+    double lengthSeconds{0.0};
+    juce::int64 lengthSamples{0};
+
+    // Playback position (audio thread)
+    size_t cursor{0};
+    juce::int64 position{0};
+    bool looping{true};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiFileSequencer)
+};
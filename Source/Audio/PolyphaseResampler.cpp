@@ -0,0 +1,256 @@
+#include "PolyphaseResampler.h"
+#include <cmath>
+#include <cstring>
+
+#if JUCE_INTEL
+ #include <xmmintrin.h>
+#elif JUCE_ARM && (defined (__ARM_NEON) || defined (__ARM_NEON__))
+ #include <arm_neon.h>
+ #define TOWELHOST_RESAMPLER_NEON 1
+#endif
+
+namespace
+{
+    struct QualitySettings
+    {
+        int tapsPerPhase;
+        double attenuationDb;
+    };
+
+    QualitySettings getSettings(PolyphaseResampler::Quality quality)
+    {
+        switch (quality)
+        {
+            case PolyphaseResampler::Quality::Fast:     return { 32, 70.0 };
+            case PolyphaseResampler::Quality::Balanced: return { 144, 90.0 };
+            case PolyphaseResampler::Quality::Best:     return { 192, 110.0 };
+        }
+
+        return { 144, 90.0 };
+    }
+
+    juce::int64 greatestCommonDivisor(juce::int64 a, juce::int64 b)
+    {
+        while (b != 0)
+        {
+            const auto remainder = a % b;
+            a = b;
+            b = remainder;
+        }
+        return a;
+    }
+
+    // Zeroth-order modified Bessel function, for the Kaiser window
+    double besselI0(double x)
+    {
+        double sum = 1.0, term = 1.0;
+        for (int k = 1; k < 64 && term > sum * 1.0e-12; ++k)
+        {
+            const double t = x / (2.0 * k);
+            term *= t * t;
+            sum += term;
+        }
+        return sum;
+    }
+
+    // numTaps is a multiple of 8
+    inline float dotProduct(const float* taps, const float* samples, int numTaps) noexcept
+    {
+       #if JUCE_INTEL
+        __m128 sum0 = _mm_setzero_ps();
+        __m128 sum1 = _mm_setzero_ps();
+
+        for (int i = 0; i < numTaps; i += 8)
+        {
+            sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(taps + i), _mm_loadu_ps(samples + i)));
+            sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(taps + i + 4), _mm_loadu_ps(samples + i + 4)));
+        }
+
+        float lanes[4];
+        _mm_storeu_ps(lanes, _mm_add_ps(sum0, sum1));
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+       #elif TOWELHOST_RESAMPLER_NEON
+        float32x4_t sum0 = vdupq_n_f32(0.0f);
+        float32x4_t sum1 = vdupq_n_f32(0.0f);
+
+        for (int i = 0; i < numTaps; i += 8)
+        {
+            sum0 = vmlaq_f32(sum0, vld1q_f32(taps + i), vld1q_f32(samples + i));
+            sum1 = vmlaq_f32(sum1, vld1q_f32(taps + i + 4), vld1q_f32(samples + i + 4));
+        }
+
+        const float32x4_t sum = vaddq_f32(sum0, sum1);
+        const float32x2_t half = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+        return vget_lane_f32(vpadd_f32(half, half), 0);
+       #else
+        float sum[4] = {};
+        for (int i = 0; i < numTaps; i += 4)
+            for (int j = 0; j < 4; ++j)
+                sum[j] += taps[i + j] * samples[i + j];
+        return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+       #endif
+    }
+}
+
+juce::String PolyphaseResampler::getQualityName(Quality quality)
+{
+    switch (quality)
+    {
+        case Quality::Fast:     return "fast";
+        case Quality::Balanced: return "balanced";
+        case Quality::Best:     return "best";
+    }
+
+    return {};
+}
+
+bool PolyphaseResampler::parseQuality(const juce::String& name, Quality& quality)
+{
+    for (auto candidate : { Quality::Fast, Quality::Balanced, Quality::Best })
+    {
+        if (name.equalsIgnoreCase(getQualityName(candidate)))
+        {
+            quality = candidate;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+juce::String PolyphaseResampler::checkRates(double sourceRate, double targetRate, Quality quality)
+{
+    const auto source = (juce::int64) sourceRate;
+    const auto target = (juce::int64) targetRate;
+
+    if (source <= 0 || target <= 0 || (double) source != sourceRate || (double) target != targetRate)
+        return "Can only convert between whole-number sample rates";
+
+    // The filter has one phase per step of the reduced ratio
+    const auto divisor = greatestCommonDivisor(source, target);
+    const auto up = target / divisor;
+    const auto down = source / divisor;
+
+    if (up > 4096 || down > 4096 || up * getSettings(quality).tapsPerPhase > (1 << 20))
+        return "Can't convert " + juce::String(sourceRate) + " Hz to " + juce::String(targetRate) + " Hz";
+
+    return {};
+}
+
+juce::String PolyphaseResampler::prepare(int numChannels, double sourceRate, double targetRate, Quality quality, int maxInputSamples)
+{
+    auto error = checkRates(sourceRate, targetRate, quality);
+    if (error.isNotEmpty())
+        return error;
+
+    const auto divisor = greatestCommonDivisor((juce::int64) sourceRate, (juce::int64) targetRate);
+    upFactor = (int) ((juce::int64) targetRate / divisor);
+    downFactor = (int) ((juce::int64) sourceRate / divisor);
+    numTaps = getSettings(quality).tapsPerPhase;
+    maxInput = juce::jmax(1, maxInputSamples);
+
+    designFilter(quality, sourceRate, targetRate);
+    history.setSize(juce::jmax(1, numChannels), numTaps - 1 + maxInput);
+    reset();
+
+    return {};
+}
+
+void PolyphaseResampler::reset()
+{
+    history.clear();
+
+    // The first output lines up with the first input sample
+    position = numTaps - 1;
+    phase = 0;
+}
+
+void PolyphaseResampler::designFilter(Quality quality, double sourceRate, double targetRate)
+{
+    const auto settings = getSettings(quality);
+    const int length = upFactor * numTaps;
+    const double prototypeRate = sourceRate * upFactor;
+    const double nyquist = juce::jmin(sourceRate, targetRate) * 0.5;
+
+    // Kaiser estimate of the transition band this length allows; the stopband
+    // starts at the lower Nyquist frequency so nothing aliases below it
+    const double transition = (settings.attenuationDb - 8.0) * prototypeRate
+                            / (2.285 * juce::MathConstants<double>::twoPi * (length - 1));
+    const double cutoff = (nyquist - transition * 0.5) / prototypeRate;
+    const double beta = 0.1102 * (settings.attenuationDb - 8.7);
+    const double centre = (length - 1) * 0.5;
+
+    std::vector<double> prototype((size_t) length);
+    double sum = 0.0;
+
+    for (int i = 0; i < length; ++i)
+    {
+        const double x = i - centre;
+        const double sinc = x == 0.0 ? 2.0 * cutoff
+                                     : std::sin(juce::MathConstants<double>::twoPi * cutoff * x) / (juce::MathConstants<double>::pi * x);
+        const double ratio = 2.0 * i / (length - 1) - 1.0;
+        const double window = besselI0(beta * std::sqrt(juce::jmax(0.0, 1.0 - ratio * ratio))) / besselI0(beta);
+
+        prototype[(size_t) i] = sinc * window;
+        sum += prototype[(size_t) i];
+    }
+
+    // Unity gain through the zero-stuffed upsampling; each phase's taps are
+    // stored newest-sample-last so the dot product runs forwards over history
+    coefficients.assign((size_t) length, 0.0f);
+    const double gain = upFactor / sum;
+
+    for (int p = 0; p < upFactor; ++p)
+        for (int k = 0; k < numTaps; ++k)
+            coefficients[(size_t) (p * numTaps + numTaps - 1 - k)] = (float) (prototype[(size_t) (p + k * upFactor)] * gain);
+
+    latency = centre / downFactor;
+    passbandEdge = nyquist - transition;
+    stopbandAttenuation = settings.attenuationDb;
+}
+
+int PolyphaseResampler::getNumOutputSamples(int numInputSamples) const noexcept
+{
+    // Outputs whose newest input sample falls inside the new input
+    const auto available = (juce::int64) (numTaps - 1 + numInputSamples - position);
+    if (available <= 0)
+        return 0;
+
+    return (int) ((available * upFactor - phase + downFactor - 1) / downFactor);
+}
+
+int PolyphaseResampler::process(const float* const* input, float* const* output, int numChannels, int numInputSamples) noexcept
+{
+    jassert(numInputSamples <= maxInput);
+    numInputSamples = juce::jlimit(0, maxInput, numInputSamples);
+    numChannels = juce::jmin(numChannels, history.getNumChannels());
+
+    const int numOutputSamples = getNumOutputSamples(numInputSamples);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* samples = history.getWritePointer(ch);
+        juce::FloatVectorOperations::copy(samples + numTaps - 1, input[ch], numInputSamples);
+
+        auto* out = output[ch];
+        int pos = position;
+        int ph = phase;
+
+        for (int i = 0; i < numOutputSamples; ++i)
+        {
+            out[i] = dotProduct(coefficients.data() + ph * numTaps, samples + pos - (numTaps - 1), numTaps);
+
+            ph += downFactor;
+            pos += ph / upFactor;
+            ph %= upFactor;
+        }
+
+        // Keep the newest samples as history for the next block
+        std::memmove(samples, samples + numInputSamples, sizeof(float) * (size_t) (numTaps - 1));
+    }
+
+    const auto steps = (juce::int64) phase + (juce::int64) numOutputSamples * downFactor;
+    position += (int) (steps / upFactor) - numInputSamples;
+    phase = (int) (steps % upFactor);
+    return numOutputSamples;
+}
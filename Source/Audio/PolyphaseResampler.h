@@ -0,0 +1,76 @@
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+
+// Streaming sample rate converter for a fixed ratio between two integer rates,
+// e.g. 44100 -> 48000 (147:160).
+//
+// A Kaiser-windowed sinc low-pass is designed once at the common multiple of
+// both rates and split into one short filter per output phase, so each output
+// sample is a single dot product of one phase's taps with the latest input.
+// The dot product uses SSE or NEON where available. All state is allocated in
+// prepare(); process() keeps the last few input samples of each channel so
+// block boundaries are seamless.
+class PolyphaseResampler
+{
+public:
+    enum class Quality
+    {
+        // Taps per phase, stopband, and passband edge between 44.1 and 48 kHz
+        // (the transition band scales with the source rate)
+        Fast,     // 32 taps, 70 dB, to about 15.6-16.1 kHz
+        Balanced, // 144 taps, 90 dB, to about 20.1-20.3 kHz
+        Best      // 192 taps, 110 dB, to about 20.3-20.4 kHz
+    };
+
+    static juce::String getQualityName(Quality quality);
+    static bool parseQuality(const juce::String& name, Quality& quality);
+
+    // Returns an error message if this conversion isn't supported, or an empty string
+    static juce::String checkRates(double sourceRate, double targetRate, Quality quality);
+
+    PolyphaseResampler() = default;
+
+    // Returns an error message if the ratio can't be converted, or an empty
+    // string on success
+    juce::String prepare(int numChannels, double sourceRate, double targetRate, Quality quality, int maxInputSamples);
+    void reset();
+
+    // Output samples the next process() call writes for this many input samples
+    int getNumOutputSamples(int numInputSamples) const noexcept;
+
+    // Most output samples a call with maxInputSamples can write
+    int getMaxOutputSamples() const noexcept { return (int) (((juce::int64) maxInput * upFactor) / downFactor) + 1; }
+
+    // Converts at most maxInputSamples per channel; returns the number of
+    // samples written to each output channel
+    int process(const float* const* input, float* const* output, int numChannels, int numInputSamples) noexcept;
+
+    // Group delay of the filter, in samples at the target rate
+    double getLatencyInTargetSamples() const noexcept { return latency; }
+
+    int getTapsPerPhase() const noexcept { return numTaps; }
+    double getPassbandEdgeHz() const noexcept { return passbandEdge; }
+    double getStopbandAttenuationDb() const noexcept { return stopbandAttenuation; }
+
+private:
+    void designFilter(Quality quality, double sourceRate, double targetRate);
+
+    int upFactor{1};   // L: phases per input sample
+    int downFactor{1}; // M: phase step per output sample
+    int numTaps{0};
+    int maxInput{0};
+
+    std::vector<float> coefficients; // numTaps per phase, each phase reversed
+    juce::AudioBuffer<float> history; // numTaps - 1 previous samples, then the new input
+
+    // Next output: history index of its newest input sample, and its phase
+    int position{0};
+    int phase{0};
+
+    double latency{0.0};
+    double passbandEdge{0.0};
+    double stopbandAttenuation{0.0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PolyphaseResampler)
+};
@@ -0,0 +1,120 @@
+#include "RealtimeWorkerPool.h"
+#include "../Diagnostics/Tracer.h"
+#include <thread>
+
+class RealtimeWorkerPool::Worker : public juce::Thread
+{
+public:
+    Worker(RealtimeWorkerPool& ownerPool, int index)
+        : juce::Thread("Multi-mono worker " + juce::String(index)), pool(ownerPool) {}
+
+    void run() override
+    {
+        Tracer::nameCurrentThread("Multi-mono worker");
+        auto lastBatch = pool.batchNumber.load();
+        auto lastBatchTime = juce::Time::getMillisecondCounter();
+
+        while (!threadShouldExit())
+        {
+            const auto batch = pool.batchNumber.load(std::memory_order_acquire);
+            if (batch != lastBatch)
+            {
+                lastBatch = batch;
+                lastBatchTime = juce::Time::getMillisecondCounter();
+                while (pool.performNextJob()) {}
+                continue;
+            }
+
+            // The audio thread never wakes us (that would take a lock), so keep
+            // polling, yielding the core, while batches are coming, and drop to
+            // polling once a millisecond when they stop
+            if (juce::Time::getMillisecondCounter() - lastBatchTime < busyPollMs)
+                std::this_thread::yield();
+            else
+                juce::Thread::sleep(1);
+        }
+    }
+
+private:
+    // Longer than any callback period, so a running device keeps the workers polling
+    static constexpr juce::uint32 busyPollMs = 100;
+
+    RealtimeWorkerPool& pool;
+};
+
+RealtimeWorkerPool::~RealtimeWorkerPool()
+{
+    stop();
+}
+
+void RealtimeWorkerPool::start(int numWorkers)
+{
+    stop();
+
+    const int numCpus = juce::SystemStats::getNumCpus();
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        auto* worker = workers.add(new Worker(*this, i));
+
+        // Leave core 0 to the audio thread (ignored on macOS)
+        if (numCpus > 1)
+            worker->setAffinityMask(1u << (juce::uint32) (1 + i % juce::jmin(31, numCpus - 1)));
+
+        worker->startThread(juce::Thread::realtimeAudioPriority);
+    }
+}
+
+void RealtimeWorkerPool::stop()
+{
+    for (auto* worker : workers)
+        worker->signalThreadShouldExit();
+
+    for (auto* worker : workers)
+        worker->stopThread(1000);
+
+    workers.clear();
+}
+
+void RealtimeWorkerPool::run(Job& job, int numJobs)
+{
+    if (numJobs <= 0)
+        return;
+
+    currentJob.store(&job);
+    jobsRemaining.store(numJobs);
+    jobState.store((juce::uint64) numJobs << 32, std::memory_order_release);
+    batchNumber.fetch_add(1, std::memory_order_release);
+
+    // The audio thread works through the batch too, so a worker that is late
+    // or asleep only costs speed
+    while (performNextJob()) {}
+
+    // Only jobs a worker has already started are left. They can't be taken
+    // back, so this waits as long as the slowest of them, plus any time its
+    // worker is preempted; realtime priority keeps that rare. The engine's
+    // overrun count shows it if it happens.
+    while (jobsRemaining.load(std::memory_order_acquire) > 0)
+        std::this_thread::yield();
+}
+
+bool RealtimeWorkerPool::performNextJob()
+{
+    auto state = jobState.load(std::memory_order_acquire);
+
+    for (;;)
+    {
+        const auto numJobs = (juce::uint32) (state >> 32);
+        const auto index = (juce::uint32) (state & 0xffffffffu);
+
+        if (index >= numJobs)
+            return false;
+
+        if (jobState.compare_exchange_weak(state, state + 1, std::memory_order_acq_rel))
+        {
+            currentJob.load(std::memory_order_acquire)->perform((int) index);
+            jobsRemaining.fetch_sub(1, std::memory_order_acq_rel);
+            return true;
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+
+// A small pool of realtime-priority threads that helps the audio thread get
+// through a batch of independent jobs inside one callback.
+//
+// The audio thread calls run(), takes jobs itself alongside the workers and
+// returns once every job has finished. Jobs are handed out through an
+// atomic counter and the workers poll for new batches instead of being
+// signalled, so dispatch never allocates, takes a lock or makes a system
+// call. Workers yield between polls while batches keep coming and poll once
+// a millisecond when they stop.
+//
+// run() returns only when every job is done. A worker preempted in the middle
+// of a job holds up the callback until it resumes; there's no bound on that
+// beyond the workers' realtime priority.
+class RealtimeWorkerPool
+{
+public:
+    struct Job
+    {
+        virtual ~Job() = default;
+        virtual void perform(int jobIndex) = 0;
+    };
+
+    RealtimeWorkerPool() = default;
+    ~RealtimeWorkerPool();
+
+    // Starts the workers, pinning each to its own core where the OS allows.
+    // Message thread only, while no batch is running.
+    void start(int numWorkers);
+    void stop();
+
+    int getNumWorkers() const { return workers.size(); }
+
+    // Runs job.perform(i) for every i in [0, numJobs) and waits for all of them
+    void run(Job& job, int numJobs);
+
+private:
+    class Worker;
+
+    bool performNextJob();
+
+    juce::OwnedArray<Worker> workers;
+
+    // Job count in the high 32 bits, next job index in the low 32 bits, so a
+    // worker that wakes late can never claim a job from the wrong batch
+    std::atomic<juce::uint64> jobState{0};
+    std::atomic<Job*> currentJob{nullptr};
+    std::atomic<int> jobsRemaining{0};
+    std::atomic<juce::uint32> batchNumber{0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RealtimeWorkerPool)
+};
@@ -0,0 +1,191 @@
+#include "RenderAhead.h"
+#include "../Diagnostics/Tracer.h"
+
+RenderAhead::RenderAhead(RenderFunction renderFunction, double aheadTimeMs, int renderBlockSize)
+    : juce::Thread("Render-ahead"),
+      render(std::move(renderFunction)),
+      aheadMs(juce::jlimit(20.0, 5000.0, aheadTimeMs)),
+      blockSize(juce::jlimit(64, 16384, renderBlockSize))
+{
+}
+
+RenderAhead::~RenderAhead()
+{
+    release();
+}
+
+juce::String RenderAhead::setSourceFile(const juce::File& file)
+{
+    jassert(!isThreadRunning());
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr)
+        return "Could not read " + file.getFullPathName();
+
+    if (reader->lengthInSamples <= 0)
+        return file.getFileName() + " is empty";
+
+    source = std::move(reader);
+    sourcePosition = 0;
+    return {};
+}
+
+void RenderAhead::prepare(int numChannels, double newSampleRate)
+{
+    release();
+
+    sampleRate = newSampleRate;
+    aheadSamples = juce::roundToInt(aheadMs * sampleRate / 1000.0);
+
+    if (source != nullptr && source->sampleRate != sampleRate)
+        DBG("Render-ahead: source file is " + juce::String(source->sampleRate) + " Hz, device is "
+            + juce::String(sampleRate) + " Hz; playing without resampling");
+
+    // Room for the ahead time plus the block being written
+    fifo.setTotalSize(aheadSamples + blockSize + 1);
+    fifo.reset();
+    ring.setSize(numChannels, aheadSamples + blockSize + 1);
+    block.setSize(numChannels, blockSize);
+    sourceBlock.setSize(source != nullptr ? (int) source->numChannels : 1, blockSize);
+    blockMidi.ensureSize(4096);
+
+    primed.store(false);
+    recentUsedSamples.store(0);
+    maxUsedSamples.store(0);
+    underruns.store(0);
+
+    startThread(8); // Above normal, but not competing with the device thread
+}
+
+void RenderAhead::release()
+{
+    stopThread(5000);
+}
+
+void RenderAhead::run()
+{
+    Tracer::nameCurrentThread("Render-ahead");
+
+    while (!threadShouldExit())
+    {
+        if (fifo.getFreeSpace() < blockSize)
+        {
+            wait(2);
+            continue;
+        }
+
+        block.clear();
+        blockMidi.clear();
+
+        if (source != nullptr)
+            readSource(block);
+
+        {
+            TRACE_SCOPE_ARG("Render-ahead block", blockSize);
+            render(block, blockMidi);
+        }
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(blockSize, start1, size1, start2, size2);
+
+        for (int ch = 0; ch < ring.getNumChannels(); ++ch)
+        {
+            if (size1 > 0)
+                ring.copyFrom(ch, start1, block, ch, 0, size1);
+            if (size2 > 0)
+                ring.copyFrom(ch, start2, block, ch, size1, size2);
+        }
+
+        fifo.finishedWrite(size1 + size2);
+
+        if (!primed.load() && fifo.getNumReady() >= aheadSamples)
+            primed.store(true);
+    }
+}
+
+// Next block of the looped source file; a mono file feeds every channel
+void RenderAhead::readSource(juce::AudioBuffer<float>& destination)
+{
+    const auto length = source->lengthInSamples;
+    int done = 0;
+
+    while (done < blockSize)
+    {
+        const int count = (int) juce::jmin((juce::int64) (blockSize - done), length - sourcePosition);
+        source->read(&sourceBlock, done, count, sourcePosition, true, true);
+
+        done += count;
+        sourcePosition += count;
+        if (sourcePosition >= length)
+            sourcePosition = 0;
+    }
+
+    const int numSourceChannels = sourceBlock.getNumChannels();
+    for (int ch = 0; ch < destination.getNumChannels(); ++ch)
+        destination.copyFrom(ch, 0, sourceBlock, ch % numSourceChannels, 0, blockSize);
+}
+
+void RenderAhead::read(float* const* outputChannelData, int numOutputChannels, int numSamples) noexcept
+{
+    auto clearOutputs = [&](int startSample, int count)
+    {
+        for (int ch = 0; ch < numOutputChannels; ++ch)
+            if (outputChannelData[ch] != nullptr)
+                juce::FloatVectorOperations::clear(outputChannelData[ch] + startSample, count);
+    };
+
+    // Silent while the ring fills for the first time
+    if (!primed.load())
+    {
+        clearOutputs(0, numSamples);
+        return;
+    }
+
+    const int available = juce::jmin(numSamples, fifo.getNumReady());
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(available, start1, size1, start2, size2);
+
+    for (int ch = 0; ch < numOutputChannels; ++ch)
+    {
+        auto* output = outputChannelData[ch];
+        if (output == nullptr)
+            continue;
+
+        if (ch < ring.getNumChannels())
+        {
+            if (size1 > 0)
+                juce::FloatVectorOperations::copy(output, ring.getReadPointer(ch, start1), size1);
+            if (size2 > 0)
+                juce::FloatVectorOperations::copy(output + size1, ring.getReadPointer(ch, start2), size2);
+        }
+        else
+        {
+            juce::FloatVectorOperations::clear(output, size1 + size2);
+        }
+    }
+
+    fifo.finishedRead(size1 + size2);
+
+    if (available < numSamples)
+    {
+        clearOutputs(available, numSamples - available);
+        underruns.fetch_add(1);
+    }
+
+    // How much of the ahead time is gone once this block has been taken
+    const int used = juce::jmax(0, aheadSamples - fifo.getNumReady());
+
+    int previous = recentUsedSamples.load();
+    while (used > previous && !recentUsedSamples.compare_exchange_weak(previous, used)) {}
+
+    previous = maxUsedSamples.load();
+    while (used > previous && !maxUsedSamples.compare_exchange_weak(previous, used)) {}
+}
+
+double RenderAhead::getAheadUsedMs() noexcept
+{
+    return samplesToMs(recentUsedSamples.exchange(0));
+}
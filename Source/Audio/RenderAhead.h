@@ -0,0 +1,76 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <functional>
+
+// Render-ahead for file-driven playback (--render-ahead, --play).
+//
+// With no live input to follow, the plugin doesn't have to run just in
+// time. A background thread renders the source (a looped audio file and/or
+// the engine's MIDI sequence) in large blocks, a few hundred milliseconds
+// ahead of the device, into a lock-free ring. The audio callback only copies
+// out of the ring, so a plugin that occasionally takes longer than one
+// device buffer no longer causes a dropout, as long as the time it falls
+// behind stays within the ahead time.
+//
+// The callback tracks how much of the ahead time was used up at worst, which
+// tells how close a plugin came to an underrun.
+class RenderAhead : private juce::Thread
+{
+public:
+    // Renders one block in place on the render thread; the buffer holds the source input
+    using RenderFunction = std::function<void(juce::AudioBuffer<float>&, juce::MidiBuffer&)>;
+
+    RenderAhead(RenderFunction render, double aheadMs, int blockSize);
+    ~RenderAhead() override;
+
+    // Message thread, before prepare(). The file is looped as the input.
+    // Returns an error message, or an empty string on success.
+    juce::String setSourceFile(const juce::File& file);
+
+    // Stops rendering, sizes the ring for this format and starts again. Output
+    // is silent until the ring has filled once.
+    void prepare(int numChannels, double sampleRate);
+    void release();
+
+    int getBlockSize() const noexcept { return blockSize; }
+    double getAheadMs() const noexcept { return aheadMs; }
+
+    // Audio thread
+    void read(float* const* outputChannelData, int numOutputChannels, int numSamples) noexcept;
+
+    // Largest share of the ahead time used up, in ms: since the previous call
+    // (single reader), and since playback started
+    double getAheadUsedMs() noexcept;
+    double getMaxAheadUsedMs() const noexcept { return samplesToMs(maxUsedSamples.load()); }
+
+    // Blocks the device asked for before the render thread had them
+    int getUnderrunCount() const noexcept { return underruns.load(); }
+
+private:
+    void run() override;
+    void readSource(juce::AudioBuffer<float>& block);
+    double samplesToMs(int numSamples) const noexcept { return numSamples * 1000.0 / sampleRate; }
+
+    RenderFunction render;
+    const double aheadMs;
+    const int blockSize;
+    double sampleRate{44100.0};
+    int aheadSamples{0};
+
+    std::unique_ptr<juce::AudioFormatReader> source;
+    juce::int64 sourcePosition{0};
+    juce::AudioBuffer<float> sourceBlock;
+
+    juce::AbstractFifo fifo{1};
+    juce::AudioBuffer<float> ring;
+    juce::AudioBuffer<float> block;
+    juce::MidiBuffer blockMidi;
+
+    std::atomic<bool> primed{false};
+    std::atomic<int> recentUsedSamples{0};
+    std::atomic<int> maxUsedSamples{0};
+    std::atomic<int> underruns{0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RenderAhead)
+};
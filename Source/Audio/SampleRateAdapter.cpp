@@ -0,0 +1,134 @@
+#include "SampleRateAdapter.h"
+
+juce::String SampleRateAdapter::prepare(int numChannels, double deviceSampleRate, double internalSampleRate,
+                                        int internalBlockSize, int maxDeviceBlockSize, PolyphaseResampler::Quality quality)
+{
+    release();
+
+    numChannels = juce::jmax(1, numChannels);
+    maxDeviceBlock = juce::jmax(1, maxDeviceBlockSize);
+    const int newBlockSize = juce::jmax(1, internalBlockSize);
+
+    auto error = inputResampler.prepare(numChannels, deviceSampleRate, internalSampleRate, quality, maxDeviceBlock);
+    if (error.isEmpty())
+        error = outputResampler.prepare(numChannels, internalSampleRate, deviceSampleRate, quality, newBlockSize);
+    if (error.isNotEmpty())
+        return error;
+
+    blockSize = newBlockSize;
+    accumulator.setSize(numChannels, blockSize + inputResampler.getMaxOutputSamples());
+    convertedBlock.setSize(numChannels, outputResampler.getMaxOutputSamples());
+
+    // One plugin block's worth of device samples, plus rounding, is always
+    // enough to read a full device chunk back
+    primeSamples = outputResampler.getMaxOutputSamples() + 2;
+    outputFifo.setSize(numChannels, primeSamples + convertedBlock.getNumSamples() + maxDeviceBlock + 8);
+
+    inputChannels.resize(numChannels);
+    outputChannels.resize(numChannels);
+    pendingMidi.ensureSize(4096);
+    remainingMidi.ensureSize(4096);
+    blockMidi.ensureSize(4096);
+
+    const double ratio = deviceSampleRate / internalSampleRate;
+    latencySamples = juce::roundToInt(inputResampler.getLatencyInTargetSamples() * ratio
+                                      + outputResampler.getLatencyInTargetSamples() + primeSamples);
+
+    reset();
+    return {};
+}
+
+void SampleRateAdapter::release()
+{
+    blockSize = 0;
+    latencySamples = 0;
+    accumulator.setSize(0, 0);
+    convertedBlock.setSize(0, 0);
+    outputFifo.setSize(0, 0);
+}
+
+void SampleRateAdapter::reset()
+{
+    inputResampler.reset();
+    outputResampler.reset();
+    accumulator.clear();
+    outputFifo.clear();
+    pendingMidi.clear();
+    blockMidi.clear();
+    inputFill = 0;
+
+    outputReadPosition = 0;
+    outputReady = primeSamples;
+}
+
+int SampleRateAdapter::convertInput(const juce::AudioBuffer<float>& deviceBuffer, int startSample, int numSamples, int numChannels)
+{
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        inputChannels.setUnchecked(ch, deviceBuffer.getReadPointer(ch, startSample));
+        outputChannels.setUnchecked(ch, accumulator.getWritePointer(ch, inputFill));
+    }
+
+    jassert(inputFill + inputResampler.getNumOutputSamples(numSamples) <= accumulator.getNumSamples());
+    return inputResampler.process(inputChannels.getRawDataPointer(), outputChannels.getRawDataPointer(), numChannels, numSamples);
+}
+
+void SampleRateAdapter::convertOutput(const juce::AudioBuffer<float>& block)
+{
+    const int numChannels = block.getNumChannels();
+    const int produced = outputResampler.process(block.getArrayOfReadPointers(), convertedBlock.getArrayOfWritePointers(),
+                                                 numChannels, blockSize);
+
+    const int capacity = outputFifo.getNumSamples();
+    const int writePosition = (outputReadPosition + outputReady) % capacity;
+    const int firstPart = juce::jmin(produced, capacity - writePosition);
+
+    jassert(outputReady + produced <= capacity);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        outputFifo.copyFrom(ch, writePosition, convertedBlock, ch, 0, firstPart);
+        if (firstPart < produced)
+            outputFifo.copyFrom(ch, 0, convertedBlock, ch, firstPart, produced - firstPart);
+    }
+
+    outputReady += produced;
+}
+
+// Moves whatever followed the processed block to the front of the accumulator
+void SampleRateAdapter::consumeBlock(int numChannels)
+{
+    inputFill -= blockSize;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* samples = accumulator.getWritePointer(ch);
+        std::memmove(samples, samples + blockSize, sizeof(float) * (size_t) inputFill);
+    }
+
+    remainingMidi.clear();
+    remainingMidi.addEvents(pendingMidi, blockSize, -1, -blockSize);
+    pendingMidi.swapWith(remainingMidi);
+}
+
+void SampleRateAdapter::readOutput(juce::AudioBuffer<float>& deviceBuffer, int startSample, int numSamples)
+{
+    const int capacity = outputFifo.getNumSamples();
+    const int numChannels = juce::jmin(deviceBuffer.getNumChannels(), outputFifo.getNumChannels());
+    const int available = juce::jmin(numSamples, outputReady);
+    const int firstPart = juce::jmin(available, capacity - outputReadPosition);
+
+    jassert(available == numSamples);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        deviceBuffer.copyFrom(ch, startSample, outputFifo, ch, outputReadPosition, firstPart);
+        if (firstPart < available)
+            deviceBuffer.copyFrom(ch, startSample + firstPart, outputFifo, ch, 0, available - firstPart);
+        if (available < numSamples)
+            deviceBuffer.clear(ch, startSample + available, numSamples - available);
+    }
+
+    outputReadPosition = (outputReadPosition + available) % capacity;
+    outputReady -= available;
+}
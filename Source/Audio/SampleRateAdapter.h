@@ -0,0 +1,104 @@
+#pragma once
+#include <JuceHeader.h>
+#include "PolyphaseResampler.h"
+
+// Runs the plugin at a fixed internal sample rate whatever rate the device
+// is set to (--sample-rate). Each device block is resampled to the internal
+// rate, collected into fixed-size plugin blocks, processed, resampled back
+// and read out through a FIFO primed with silence.
+//
+// The latency is constant: the two filters' group delays plus the primed
+// silence, which covers one plugin block. MIDI event positions are scaled to
+// the internal rate. All storage is allocated in prepare().
+class SampleRateAdapter
+{
+public:
+    SampleRateAdapter() = default;
+
+    // Returns an error message if the rates can't be converted, or an empty
+    // string on success
+    juce::String prepare(int numChannels, double deviceSampleRate, double internalSampleRate,
+                         int internalBlockSize, int maxDeviceBlockSize, PolyphaseResampler::Quality quality);
+    void release();
+    void reset();
+
+    bool isActive() const { return blockSize > 0; }
+    int getBlockSize() const { return blockSize; }
+
+    // Added latency, in device samples
+    int getLatencySamples() const { return latencySamples; }
+
+    // Processes one device block in place. render(buffer, midi) is called
+    // zero or more times with exactly getBlockSize() samples at the internal rate.
+    template <typename RenderFunction>
+    void process(juce::AudioBuffer<float>& deviceBuffer, juce::MidiBuffer& deviceMidi, RenderFunction&& render)
+    {
+        const int numChannels = juce::jmin(deviceBuffer.getNumChannels(), accumulator.getNumChannels());
+        const int totalSamples = deviceBuffer.getNumSamples();
+
+        // Larger-than-announced device blocks are handled in pieces
+        for (int chunkStart = 0; chunkStart < totalSamples; chunkStart += maxDeviceBlock)
+        {
+            const int chunkLength = juce::jmin(maxDeviceBlock, totalSamples - chunkStart);
+            const int produced = convertInput(deviceBuffer, chunkStart, chunkLength, numChannels);
+
+            for (const auto metadata : deviceMidi)
+            {
+                const int offset = metadata.samplePosition - chunkStart;
+                if (offset < 0 || offset >= chunkLength)
+                    continue;
+
+                const int position = inputFill + juce::jmin(juce::jmax(0, produced - 1), offset * produced / chunkLength);
+                pendingMidi.addEvent(metadata.data, metadata.numBytes, position);
+            }
+
+            inputFill += produced;
+
+            while (inputFill >= blockSize)
+            {
+                juce::AudioBuffer<float> block(accumulator.getArrayOfWritePointers(), numChannels, blockSize);
+                blockMidi.clear();
+                blockMidi.addEvents(pendingMidi, 0, blockSize, 0);
+
+                render(block, blockMidi);
+                convertOutput(block);
+                consumeBlock(numChannels);
+            }
+
+            readOutput(deviceBuffer, chunkStart, chunkLength);
+        }
+
+        deviceMidi.clear();
+    }
+
+private:
+    int convertInput(const juce::AudioBuffer<float>& deviceBuffer, int startSample, int numSamples, int numChannels);
+    void convertOutput(const juce::AudioBuffer<float>& block);
+    void consumeBlock(int numChannels);
+    void readOutput(juce::AudioBuffer<float>& deviceBuffer, int startSample, int numSamples);
+
+    int blockSize{0};
+    int maxDeviceBlock{0};
+    int latencySamples{0};
+    int primeSamples{0};
+
+    PolyphaseResampler inputResampler;  // Device rate -> internal rate
+    PolyphaseResampler outputResampler; // Internal rate -> device rate
+    juce::Array<const float*> inputChannels;
+    juce::Array<float*> outputChannels;
+
+    // Internal-rate input, a plugin block plus whatever one device chunk adds
+    juce::AudioBuffer<float> accumulator;
+    juce::MidiBuffer pendingMidi;
+    juce::MidiBuffer remainingMidi;
+    juce::MidiBuffer blockMidi;
+    int inputFill{0};
+
+    // Device-rate output
+    juce::AudioBuffer<float> convertedBlock;
+    juce::AudioBuffer<float> outputFifo;
+    int outputReadPosition{0};
+    int outputReady{0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SampleRateAdapter)
+};
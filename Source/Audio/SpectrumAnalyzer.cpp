@@ -0,0 +1,123 @@
+#include "SpectrumAnalyzer.h"
+
+namespace
+{
+    constexpr float smoothing = 0.35f;        // Weight of the newest frame
+    constexpr float peakDecayDbPerFrame = 0.5f;
+}
+
+SpectrumAnalyzer::SpectrumAnalyzer(AnalyzerTap& t)
+    : juce::Thread("Spectrum analyzer"),
+      tap(t),
+      history((size_t) (2 * fftSize), 0.0f),
+      incoming((size_t) fftSize, 0.0f),
+      fftData((size_t) (2 * fftSize), 0.0f)
+{
+    working.spectrumDb.fill(floorDb);
+    working.peakDb.fill(floorDb);
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer()
+{
+    stop();
+}
+
+void SpectrumAnalyzer::start(double sampleRate)
+{
+    working.sampleRate = sampleRate > 0.0 ? sampleRate : 44100.0;
+    tap.setEnabled(true);
+    startThread();
+}
+
+void SpectrumAnalyzer::stop()
+{
+    tap.setEnabled(false);
+    stopThread(1000);
+}
+
+bool SpectrumAnalyzer::getLatestFrame(Frame& destination)
+{
+    const juce::SpinLock::ScopedLockType sl(frameLock);
+
+    if (!hasNewFrame)
+        return false;
+
+    destination = published;
+    hasNewFrame = false;
+    return true;
+}
+
+void SpectrumAnalyzer::run()
+{
+    while (!threadShouldExit())
+    {
+        const int numRead = tap.pull(incoming.data(), (int) incoming.size());
+
+        if (numRead == 0)
+        {
+            wait(5);
+            continue;
+        }
+
+        for (int i = 0; i < numRead; ++i)
+        {
+            // Written twice so the last fftSize samples are always contiguous
+            history[(size_t) historyPosition] = incoming[(size_t) i];
+            history[(size_t) (historyPosition + fftSize)] = incoming[(size_t) i];
+            historyPosition = (historyPosition + 1) % fftSize;
+
+            if (++samplesSinceLastFrame >= hopSize)
+            {
+                samplesSinceLastFrame = 0;
+                analyse();
+            }
+        }
+    }
+}
+
+void SpectrumAnalyzer::analyse()
+{
+    const float* latest = history.data() + historyPosition;
+
+    std::copy(latest, latest + fftSize, fftData.begin());
+    window.multiplyWithWindowingTable(fftData.data(), (size_t) fftSize);
+    fft.performFrequencyOnlyForwardTransform(fftData.data());
+
+    // Full-scale sine reads 0 dB (Hann window has a coherent gain of 0.5)
+    const float scale = 4.0f / (float) fftSize;
+
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        const float db = juce::Decibels::gainToDecibels(fftData[(size_t) bin] * scale, floorDb);
+        auto& smoothed = working.spectrumDb[(size_t) bin];
+        auto& peak = working.peakDb[(size_t) bin];
+
+        smoothed += (db - smoothed) * smoothing;
+        peak = juce::jmax(db, peak - peakDecayDbPerFrame);
+    }
+
+    updateScope();
+
+    const juce::SpinLock::ScopedLockType sl(frameLock);
+    published = working;
+    hasNewFrame = true;
+}
+
+void SpectrumAnalyzer::updateScope()
+{
+    // Trigger on the last rising zero crossing that still leaves a full scope
+    // window, so a periodic signal stands still on screen
+    const float* latest = history.data() + historyPosition;
+    int start = fftSize - scopeSize;
+
+    for (int i = fftSize - scopeSize; i > 0; --i)
+    {
+        if (latest[i - 1] < 0.0f && latest[i] >= 0.0f)
+        {
+            start = i;
+            break;
+        }
+    }
+
+    std::copy(latest + start, latest + start + scopeSize, working.scope.begin());
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <vector>
+#include "AnalyzerTap.h"
+
+// Turns the samples from an AnalyzerTap into spectrum and scope frames on its
+// own thread: Hann window, FFT (one plan, reused), smoothing and peak-hold.
+// The view copies the latest frame whenever it repaints.
+class SpectrumAnalyzer : private juce::Thread
+{
+public:
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int numBins = fftSize / 2;
+    static constexpr int hopSize = fftSize / 4;
+    static constexpr int scopeSize = 1024;
+
+    struct Frame
+    {
+        std::array<float, numBins> spectrumDb{};
+        std::array<float, numBins> peakDb{};
+        std::array<float, scopeSize> scope{};
+        double sampleRate{44100.0};
+    };
+
+    explicit SpectrumAnalyzer(AnalyzerTap& tap);
+    ~SpectrumAnalyzer() override;
+
+    // Enables the tap and starts the thread; stop() does the reverse
+    void start(double sampleRate);
+    void stop();
+
+    // Copies the most recent frame. Returns false if nothing new since the last call.
+    bool getLatestFrame(Frame& destination);
+
+private:
+    void run() override;
+    void analyse();
+    void updateScope();
+
+    static constexpr float floorDb = -120.0f;
+
+    AnalyzerTap& tap;
+    juce::dsp::FFT fft{fftOrder};
+    juce::dsp::WindowingFunction<float> window{(size_t) fftSize, juce::dsp::WindowingFunction<float>::hann, false};
+
+    // Analysis thread only
+    std::vector<float> history;   // Circular, 2 * fftSize samples
+    int historyPosition{0};
+    int samplesSinceLastFrame{0};
+    std::vector<float> incoming;
+    std::vector<float> fftData;
+    Frame working;
+
+    // Shared with the view
+    juce::SpinLock frameLock;
+    Frame published;
+    bool hasNewFrame{false};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumAnalyzer)
+};
@@ -0,0 +1,323 @@
+#include "VirtualAudioDevice.h"
+
+const char* const VirtualAudioIODeviceType::typeName = "Virtual";
+const char* const VirtualAudioIODeviceType::deviceName = "Virtual Device";
+
+//==============================================================================
+VirtualAudioIODeviceType::VirtualAudioIODeviceType(const VirtualDeviceSettings& s)
+    : juce::AudioIODeviceType(typeName), settings(s)
+{
+}
+
+juce::StringArray VirtualAudioIODeviceType::getDeviceNames(bool) const
+{
+    return { deviceName };
+}
+
+int VirtualAudioIODeviceType::getDefaultDeviceIndex(bool) const
+{
+    return 0;
+}
+
+int VirtualAudioIODeviceType::getIndexOfDevice(juce::AudioIODevice* device, bool) const
+{
+    return device != nullptr && device->getName() == deviceName ? 0 : -1;
+}
+
+juce::AudioIODevice* VirtualAudioIODeviceType::createDevice(const juce::String& outputDeviceName, const juce::String& inputDeviceName)
+{
+    if (outputDeviceName != deviceName && inputDeviceName != deviceName)
+        return nullptr;
+
+    return new VirtualAudioDevice(settings);
+}
+
+//==============================================================================
+VirtualAudioDevice::VirtualAudioDevice(const VirtualDeviceSettings& s)
+    : juce::AudioIODevice(VirtualAudioIODeviceType::deviceName, VirtualAudioIODeviceType::typeName),
+      juce::Thread("Virtual device"),
+      settings(s),
+      sampleRate(s.sampleRate),
+      bufferSize(s.bufferSize)
+{
+}
+
+VirtualAudioDevice::~VirtualAudioDevice()
+{
+    close();
+}
+
+juce::StringArray VirtualAudioDevice::getOutputChannelNames()
+{
+    juce::StringArray names;
+    for (int ch = 0; ch < settings.numOutputChannels; ++ch)
+        names.add("Virtual Out " + juce::String(ch + 1));
+    return names;
+}
+
+juce::StringArray VirtualAudioDevice::getInputChannelNames()
+{
+    juce::StringArray names;
+    for (int ch = 0; ch < settings.numInputChannels; ++ch)
+        names.add("Virtual In " + juce::String(ch + 1));
+    return names;
+}
+
+juce::Array<double> VirtualAudioDevice::getAvailableSampleRates()
+{
+    juce::Array<double> rates{ 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+    rates.addIfNotAlreadyThere(settings.sampleRate);
+    rates.sort();
+    return rates;
+}
+
+juce::Array<int> VirtualAudioDevice::getAvailableBufferSizes()
+{
+    juce::Array<int> sizes{ 16, 32, 64, 128, 192, 256, 384, 512, 768, 1024, 2048, 4096 };
+    sizes.addIfNotAlreadyThere(settings.bufferSize);
+    sizes.sort();
+    return sizes;
+}
+
+juce::String VirtualAudioDevice::open(const juce::BigInteger& inputChannels, const juce::BigInteger& outputChannels,
+                                      double newSampleRate, int newBufferSize)
+{
+    close();
+    lastError.clear();
+
+    sampleRate = newSampleRate > 0.0 ? newSampleRate : settings.sampleRate;
+    bufferSize = newBufferSize > 0 ? newBufferSize : settings.bufferSize;
+
+    activeInputs = inputChannels;
+    activeInputs.setRange(settings.numInputChannels, juce::jmax(0, activeInputs.getHighestBit() + 1 - settings.numInputChannels), false);
+    activeOutputs = outputChannels;
+    activeOutputs.setRange(settings.numOutputChannels, juce::jmax(0, activeOutputs.getHighestBit() + 1 - settings.numOutputChannels), false);
+
+    inputBuffer.setSize(juce::jmax(1, activeInputs.countNumberOfSetBits()), bufferSize);
+    outputBuffer.setSize(juce::jmax(1, activeOutputs.countNumberOfSetBits()), bufferSize);
+    inputBuffer.clear();
+    outputBuffer.clear();
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    // The whole file is read up front, so the device thread never touches the disk
+    sourceFile.setSize(0, 0);
+    sourcePosition = 0;
+    if (settings.inputFile != juce::File())
+    {
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(settings.inputFile));
+        if (reader == nullptr || reader->lengthInSamples <= 0)
+        {
+            lastError = "Could not read " + settings.inputFile.getFullPathName();
+            return lastError;
+        }
+
+        if (reader->sampleRate != sampleRate)
+            DBG("Virtual device: " + settings.inputFile.getFileName() + " is " + juce::String(reader->sampleRate)
+                + " Hz, device is " + juce::String(sampleRate) + " Hz; playing without resampling");
+
+        sourceFile.setSize((int) reader->numChannels, (int) reader->lengthInSamples);
+        reader->read(&sourceFile, 0, (int) reader->lengthInSamples, 0, true, true);
+    }
+
+    if (settings.outputFile != juce::File())
+    {
+        settings.outputFile.deleteFile();
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> fileWriter(wav.createWriterFor(new juce::FileOutputStream(settings.outputFile),
+                                                                                sampleRate,
+                                                                                (unsigned int) outputBuffer.getNumChannels(),
+                                                                                32, {}, 0));
+        if (fileWriter == nullptr)
+        {
+            lastError = "Could not write " + settings.outputFile.getFullPathName();
+            return lastError;
+        }
+
+        writerThread.startThread();
+        writer = std::make_unique<juce::AudioFormatWriter::ThreadedWriter>(fileWriter.release(), writerThread,
+                                                                           juce::roundToInt(sampleRate * 2.0));
+    }
+
+    random.setSeed(settings.seed);
+    periods.store(0);
+    droppedPeriods.store(0);
+    overrunPeriods.store(0);
+    maxLatenessMs.store(0.0);
+    totalLatenessMs.store(0.0);
+
+    startThread(juce::Thread::realtimeAudioPriority);
+    return {};
+}
+
+void VirtualAudioDevice::close()
+{
+    stop();
+    stopThread(2000);
+
+    // Flushes whatever is still queued
+    writer = nullptr;
+    writerThread.stopThread(2000);
+}
+
+void VirtualAudioDevice::start(juce::AudioIODeviceCallback* newCallback)
+{
+    if (newCallback == nullptr || !isOpen())
+        return;
+
+    newCallback->audioDeviceAboutToStart(this);
+
+    const juce::ScopedLock sl(callbackLock);
+    callback = newCallback;
+}
+
+void VirtualAudioDevice::stop()
+{
+    juce::AudioIODeviceCallback* oldCallback = nullptr;
+    {
+        const juce::ScopedLock sl(callbackLock);
+        std::swap(callback, oldCallback);
+    }
+
+    if (oldCallback != nullptr)
+        oldCallback->audioDeviceStopped();
+}
+
+bool VirtualAudioDevice::isPlaying()
+{
+    const juce::ScopedLock sl(callbackLock);
+    return callback != nullptr;
+}
+
+void VirtualAudioDevice::run()
+{
+    const double periodTicks = bufferSize / sampleRate * (double) juce::Time::getHighResolutionTicksPerSecond();
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    juce::int64 period = 0;
+
+    while (!threadShouldExit())
+    {
+        // A buffer is due at the end of each period
+        const auto deadline = startTicks + (juce::int64) ((double) (period + 1) * periodTicks);
+        const double jitterMs = settings.jitterMs > 0.0 ? random.nextDouble() * settings.jitterMs : 0.0;
+        waitUntil(deadline + juce::Time::secondsToHighResolutionTicks(jitterMs / 1000.0));
+
+        if (threadShouldExit())
+            break;
+
+        ++period;
+        const double latenessMs = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - deadline) * 1000.0;
+        totalLatenessMs.store(totalLatenessMs.load() + latenessMs);
+        if (latenessMs > maxLatenessMs.load())
+            maxLatenessMs.store(latenessMs);
+
+        // A missed wakeup: the driver never asks for this buffer
+        if (settings.dropProbability > 0.0 && random.nextDouble() < settings.dropProbability)
+        {
+            renderPeriod(false);
+            droppedPeriods.fetch_add(1);
+            periods.fetch_add(1);
+            continue;
+        }
+
+        renderPeriod(true);
+        periods.fetch_add(1);
+
+        // The callback overran by more than the next period's buffer: those periods are lost
+        const auto nextDeadline = startTicks + (juce::int64) ((double) (period + 1) * periodTicks);
+        const auto missed = (juce::int64) ((double) (juce::Time::getHighResolutionTicks() - nextDeadline) / periodTicks);
+
+        for (juce::int64 i = 0; i < missed && !threadShouldExit(); ++i)
+        {
+            ++period;
+            renderPeriod(false);
+            overrunPeriods.fetch_add(1);
+            periods.fetch_add(1);
+        }
+    }
+}
+
+// One buffer period; a lost period still consumes input and records silence,
+// so files stay aligned with the device timeline
+void VirtualAudioDevice::renderPeriod(bool callEngine)
+{
+    readInput();
+    outputBuffer.clear();
+
+    if (callEngine)
+    {
+        const juce::ScopedLock sl(callbackLock);
+
+        if (callback != nullptr)
+            callback->audioDeviceIOCallback(inputBuffer.getArrayOfReadPointers(), activeInputs.countNumberOfSetBits(),
+                                            outputBuffer.getArrayOfWritePointers(), activeOutputs.countNumberOfSetBits(),
+                                            bufferSize);
+    }
+
+    if (writer != nullptr)
+        writer->write(outputBuffer.getArrayOfReadPointers(), bufferSize);
+}
+
+void VirtualAudioDevice::readInput()
+{
+    const int numInputs = activeInputs.countNumberOfSetBits();
+
+    // Loopback: output channel n is heard on input channel n one buffer later
+    if (settings.loopback)
+    {
+        inputBuffer.clear();
+        for (int ch = 0; ch < juce::jmin(numInputs, outputBuffer.getNumChannels()); ++ch)
+            inputBuffer.copyFrom(ch, 0, outputBuffer, ch, 0, bufferSize);
+        return;
+    }
+
+    if (sourceFile.getNumChannels() == 0)
+    {
+        inputBuffer.clear();
+        return;
+    }
+
+    int done = 0;
+    while (done < bufferSize)
+    {
+        const int count = juce::jmin(bufferSize - done, sourceFile.getNumSamples() - sourcePosition);
+
+        for (int ch = 0; ch < numInputs; ++ch)
+            inputBuffer.copyFrom(ch, done, sourceFile, ch % sourceFile.getNumChannels(), sourcePosition, count);
+
+        done += count;
+        sourcePosition += count;
+        if (sourcePosition >= sourceFile.getNumSamples())
+            sourcePosition = 0;
+    }
+}
+
+// Sleeps most of the way, then yields until the exact tick
+void VirtualAudioDevice::waitUntil(juce::int64 ticks)
+{
+    for (;;)
+    {
+        const double remainingMs = juce::Time::highResolutionTicksToSeconds(ticks - juce::Time::getHighResolutionTicks()) * 1000.0;
+        if (remainingMs <= 0.0 || threadShouldExit())
+            return;
+
+        if (remainingMs > 2.0)
+            wait((int) (remainingMs - 1.5));
+        else
+            juce::Thread::yield();
+    }
+}
+
+juce::String VirtualAudioDevice::getSummary() const
+{
+    const int numPeriods = periods.load();
+
+    juce::String summary;
+    summary << "Virtual device: " << numPeriods << " periods of " << bufferSize << " samples at "
+            << juce::String(sampleRate, 0) << " Hz, " << droppedPeriods.load() << " dropped, "
+            << overrunPeriods.load() << " lost to overruns; wakeup lateness mean "
+            << juce::String(numPeriods > 0 ? totalLatenessMs.load() / numPeriods : 0.0, 3) << " ms, max "
+            << juce::String(maxLatenessMs.load(), 3) << " ms";
+    return summary;
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+
+// Virtual audio device (--virtual-device) for running the realtime engine
+// without audio hardware, e.g. soak tests on a build server. That still means
+// a macOS one: the only exporter is Xcode and the loader only loads AUs. This
+// class only uses cross-platform JUCE, so it won't be what stops a Linux port.
+//
+// A high-resolution thread calls the engine once per buffer period against an
+// absolute schedule, so timing doesn't drift. Each wakeup can be delayed by
+// random jitter or dropped. A dropped period is lost and counted as an xrun,
+// as a driver would report it. When a callback overruns by more than a whole
+// period, the missed periods are skipped and counted too. The random sequence
+// is seeded, so a run can be repeated exactly.
+//
+// Input comes from a looped audio file (loaded into memory when the device
+// opens), from the device's own output one buffer earlier (loopback, for
+// latency measurement), or is silent. The output can be recorded to a WAV
+// file on a background thread.
+struct VirtualDeviceSettings
+{
+    double sampleRate{48000.0};
+    int bufferSize{256};
+    int numInputChannels{2};
+    int numOutputChannels{2};
+
+    double jitterMs{0.0};        // Largest random delay of a wakeup
+    double dropProbability{0.0}; // Chance that a wakeup is missed entirely
+    juce::int64 seed{1};
+
+    juce::File inputFile;
+    juce::File outputFile;
+    bool loopback{false};
+};
+
+class VirtualAudioIODeviceType : public juce::AudioIODeviceType
+{
+public:
+    static const char* const typeName;
+    static const char* const deviceName;
+
+    explicit VirtualAudioIODeviceType(const VirtualDeviceSettings& settings);
+
+    void scanForDevices() override {}
+    juce::StringArray getDeviceNames(bool wantInputNames) const override;
+    int getDefaultDeviceIndex(bool forInput) const override;
+    int getIndexOfDevice(juce::AudioIODevice* device, bool asInput) const override;
+    bool hasSeparateInputsAndOutputs() const override { return false; }
+    juce::AudioIODevice* createDevice(const juce::String& outputDeviceName, const juce::String& inputDeviceName) override;
+
+private:
+    VirtualDeviceSettings settings;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VirtualAudioIODeviceType)
+};
+
+class VirtualAudioDevice : public juce::AudioIODevice,
+                           private juce::Thread
+{
+public:
+    explicit VirtualAudioDevice(const VirtualDeviceSettings& settings);
+    ~VirtualAudioDevice() override;
+
+    juce::StringArray getOutputChannelNames() override;
+    juce::StringArray getInputChannelNames() override;
+    juce::Array<double> getAvailableSampleRates() override;
+    juce::Array<int> getAvailableBufferSizes() override;
+    int getDefaultBufferSize() override { return settings.bufferSize; }
+
+    juce::String open(const juce::BigInteger& inputChannels, const juce::BigInteger& outputChannels,
+                      double sampleRate, int bufferSizeSamples) override;
+    void close() override;
+    bool isOpen() override { return isThreadRunning(); }
+
+    void start(juce::AudioIODeviceCallback* callback) override;
+    void stop() override;
+    bool isPlaying() override;
+    juce::String getLastError() override { return lastError; }
+
+    int getCurrentBufferSizeSamples() override { return bufferSize; }
+    double getCurrentSampleRate() override { return sampleRate; }
+    int getCurrentBitDepth() override { return 32; }
+    juce::BigInteger getActiveOutputChannels() const override { return activeOutputs; }
+    juce::BigInteger getActiveInputChannels() const override { return activeInputs; }
+
+    // With loopback, the output comes back in one buffer later
+    int getOutputLatencyInSamples() override { return settings.loopback ? bufferSize : 0; }
+    int getInputLatencyInSamples() override { return 0; }
+
+    int getXRunCount() const noexcept override { return droppedPeriods.load() + overrunPeriods.load(); }
+
+    // Periods, lost periods and wakeup lateness since the device opened
+    juce::String getSummary() const;
+
+private:
+    void run() override;
+    void renderPeriod(bool callEngine);
+    void readInput();
+    void waitUntil(juce::int64 ticks);
+
+    const VirtualDeviceSettings settings;
+    juce::String lastError;
+
+    double sampleRate{48000.0};
+    int bufferSize{256};
+    juce::BigInteger activeInputs, activeOutputs;
+
+    juce::CriticalSection callbackLock;
+    juce::AudioIODeviceCallback* callback{nullptr};
+
+    juce::AudioBuffer<float> inputBuffer;
+    juce::AudioBuffer<float> outputBuffer;
+    juce::AudioBuffer<float> sourceFile;
+    int sourcePosition{0};
+
+    juce::TimeSliceThread writerThread{"Virtual device writer"};
+    std::unique_ptr<juce::AudioFormatWriter::ThreadedWriter> writer;
+
+    juce::Random random;
+
+    // Written by the device thread
+    std::atomic<int> periods{0};
+    std::atomic<int> droppedPeriods{0};
+    std::atomic<int> overrunPeriods{0};
+    std::atomic<double> maxLatenessMs{0.0};
+    std::atomic<double> totalLatenessMs{0.0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VirtualAudioDevice)
+};
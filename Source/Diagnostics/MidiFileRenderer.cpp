@@ -0,0 +1,105 @@
+#include "MidiFileRenderer.h"
+#include "../Audio/AudioEngine.h"
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    double percentile(std::vector<double> values, double proportion)
+    {
+        if (values.empty())
+            return 0.0;
+
+        const auto index = (size_t) juce::jlimit(0, (int) values.size() - 1, (int) (proportion * (double) (values.size() - 1) + 0.5));
+        std::nth_element(values.begin(), values.begin() + (std::ptrdiff_t) index, values.end());
+        return values[index];
+    }
+}
+
+MidiFileRenderer::MidiFileRenderer(AudioEngine& e, const Settings& s)
+    : engine(e), settings(s)
+{
+}
+
+bool MidiFileRenderer::run()
+{
+    auto sequence = std::make_unique<MidiFileSequencer>();
+    auto error = sequence->load(settings.midiFile);
+    if (error.isNotEmpty())
+    {
+        summary = "Render: " + error;
+        return false;
+    }
+
+    sequence->setLooping(false);
+    const auto fileName = sequence->getFileName();
+    const auto numEvents = sequence->getNumEvents();
+    const int numChannels = juce::jmax(1, settings.numChannels);
+    const auto totalSamples = (juce::int64) ((sequence->getLengthInSeconds() + settings.tailSeconds) * settings.sampleRate);
+
+    settings.outputFile.deleteFile();
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(new juce::FileOutputStream(settings.outputFile),
+                                                                        settings.sampleRate,
+                                                                        (unsigned int) numChannels,
+                                                                        32, {}, 0));
+    if (writer == nullptr)
+    {
+        summary = "Render: could not write " + settings.outputFile.getFullPathName();
+        return false;
+    }
+
+    engine.setMidiSequence(std::move(sequence));
+    engine.prepareOffline(settings.sampleRate, settings.blockSize, numChannels);
+
+    juce::AudioBuffer<float> block(numChannels, settings.blockSize);
+    juce::MidiBuffer blockMidi;
+    blockMidi.ensureSize(4096);
+
+    std::vector<double> blockTimes;
+    blockTimes.reserve((size_t) (totalSamples / settings.blockSize + 1));
+    bool written = true;
+
+    for (juce::int64 position = 0; position < totalSamples && written; position += settings.blockSize)
+    {
+        const int numSamples = (int) juce::jmin((juce::int64) settings.blockSize, totalSamples - position);
+
+        juce::AudioBuffer<float> view(block.getArrayOfWritePointers(), numChannels, numSamples);
+        view.clear();
+        blockMidi.clear();
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        engine.processOffline(view, blockMidi);
+        blockTimes.push_back(juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1000.0);
+
+        written = writer->writeFromAudioSampleBuffer(view, 0, numSamples);
+    }
+
+    writer = nullptr;
+    engine.setMidiSequence(nullptr);
+
+    if (!written)
+    {
+        summary = "Render: could not write " + settings.outputFile.getFullPathName();
+        return false;
+    }
+
+    double totalMs = 0.0;
+    for (auto time : blockTimes)
+        totalMs += time;
+
+    const double audioSeconds = (double) totalSamples / settings.sampleRate;
+    const double blockMs = settings.blockSize * 1000.0 / settings.sampleRate;
+
+    summary = "=== Render: " + fileName + " -> " + settings.outputFile.getFullPathName() + " ===\n";
+    summary << numEvents << " events, " << juce::String(audioSeconds, 2) << " s at "
+            << juce::String(settings.sampleRate, 0) << " Hz, " << settings.blockSize << "-sample blocks\n"
+            << "Rendered in " << juce::String(totalMs / 1000.0, 3) << " s ("
+            << juce::String(totalMs > 0.0 ? audioSeconds * 1000.0 / totalMs : 0.0, 1) << "x realtime)\n"
+            << "Block time: median " << juce::String(percentile(blockTimes, 0.5), 3) << " ms"
+            << ", p95 " << juce::String(percentile(blockTimes, 0.95), 3) << " ms"
+            << ", max " << juce::String(blockTimes.empty() ? 0.0 : *std::max_element(blockTimes.begin(), blockTimes.end()), 3) << " ms"
+            << " (block is " << juce::String(blockMs, 3) << " ms)\n";
+
+    return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <JuceHeader.h>
+
+class AudioEngine;
+
+// Offline render of a MIDI file through the engine (--render), for
+// repeatable instrument renders and benchmarks.
+//
+// The file plays once from the start through the same processing path as
+// live playback, followed by a tail, and is written as a 32-bit float WAV.
+// Every block is timed, and the summary gives the realtime factor and the
+// median, 95th percentile and worst block time.
+class MidiFileRenderer
+{
+public:
+    struct Settings
+    {
+        juce::File midiFile;
+        juce::File outputFile;
+        double sampleRate{48000.0};
+        int blockSize{512};
+        int numChannels{2};
+        double tailSeconds{2.0};
+    };
+
+    MidiFileRenderer(AudioEngine& engine, const Settings& settings);
+
+    // Returns true if the file was rendered and written
+    bool run();
+
+    juce::String getSummary() const { return summary; }
+
+private:
+    AudioEngine& engine;
+    Settings settings;
+    juce::String summary;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiFileRenderer)
+};
@@ -0,0 +1,546 @@
+#include "RealtimeAuditor.h"
+#include <atomic>
+#include <pthread.h>
+#include <time.h>
+#include <execinfo.h>
+
+#if JUCE_MAC
+ #include <malloc/malloc.h>
+ #include <mach/mach.h>
+ #include <Availability.h>
+
+ // The malloc_type_* entry points (typed allocation, macOS 14 and later) only
+ // exist in the zone struct of newer SDKs
+ #if defined(__MAC_14_0) && __MAC_OS_X_VERSION_MAX_ALLOWED >= __MAC_14_0
+  #define TOWELHOST_AUDIT_TYPED_MALLOC 1
+ #else
+  #define TOWELHOST_AUDIT_TYPED_MALLOC 0
+ #endif
+#endif
+
+namespace
+{
+    std::atomic<bool> auditEnabled{false};
+    pthread_key_t scopeKey;
+
+    // Totals across all audited threads
+    std::atomic<juce::int64> blocksAudited{0};
+    std::atomic<juce::int64> blocksWithAllocations{0};
+    std::atomic<juce::int64> allocationCount{0};
+    std::atomic<juce::int64> allocatedBytes{0};
+    std::atomic<juce::int64> freeCount{0};
+    std::atomic<int> maxAllocationsPerBlock{0};
+    std::atomic<juce::int64> waitCount{0};
+    std::atomic<double> totalWaitSeconds{0.0};
+    std::atomic<double> maxWaitSeconds{0.0};
+    std::atomic<double> waitFailThresholdSeconds{0.0};
+
+    // Fixed-size open-addressed table of distinct allocation call stacks
+    constexpr int maxStacks = 256;
+    constexpr int maxFrames = 24;
+    constexpr int framesToSkip = 3; // backtrace, recordStack, the zone hook
+
+    struct StackRecord
+    {
+        std::atomic<juce::uint64> hash{0};
+        std::atomic<bool> ready{false};
+        void* frames[maxFrames];
+        int numFrames{0};
+        std::atomic<juce::int64> count{0};
+        std::atomic<juce::int64> bytes{0};
+    };
+
+    StackRecord stacks[maxStacks];
+    std::atomic<juce::int64> droppedStacks{0};
+
+    double getThreadCpuSeconds() noexcept
+    {
+        timespec ts;
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+            return 0.0;
+
+        return (double) ts.tv_sec + ts.tv_nsec * 1.0e-9;
+    }
+
+    template <typename ValueType>
+    void storeMax(std::atomic<ValueType>& target, ValueType value) noexcept
+    {
+        auto current = target.load(std::memory_order_relaxed);
+        while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+    }
+
+    template <typename ValueType>
+    void addTo(std::atomic<ValueType>& target, ValueType value) noexcept
+    {
+        auto current = target.load(std::memory_order_relaxed);
+        while (!target.compare_exchange_weak(current, current + value, std::memory_order_relaxed)) {}
+    }
+}
+
+//==============================================================================
+#if JUCE_MAC
+namespace
+{
+    // The original function table of each zone we patched
+    struct ZoneFunctions
+    {
+        malloc_zone_t* zone{nullptr};
+        void* (*malloc)(malloc_zone_t*, size_t){nullptr};
+        void* (*calloc)(malloc_zone_t*, size_t, size_t){nullptr};
+        void* (*valloc)(malloc_zone_t*, size_t){nullptr};
+        void* (*realloc)(malloc_zone_t*, void*, size_t){nullptr};
+        void* (*memalign)(malloc_zone_t*, size_t, size_t){nullptr};
+        void (*free)(malloc_zone_t*, void*){nullptr};
+        void (*freeDefiniteSize)(malloc_zone_t*, void*, size_t){nullptr};
+        unsigned (*batchMalloc)(malloc_zone_t*, size_t, void**, unsigned){nullptr};
+        void (*batchFree)(malloc_zone_t*, void**, unsigned){nullptr};
+       #if TOWELHOST_AUDIT_TYPED_MALLOC
+        void* (*typedMalloc)(malloc_zone_t*, size_t, malloc_type_id_t){nullptr};
+        void* (*typedCalloc)(malloc_zone_t*, size_t, size_t, malloc_type_id_t){nullptr};
+        void* (*typedRealloc)(malloc_zone_t*, void*, size_t, malloc_type_id_t){nullptr};
+        void* (*typedMemalign)(malloc_zone_t*, size_t, size_t, malloc_type_id_t){nullptr};
+       #endif
+    };
+
+    // Zone struct versions that added the entry points we hook
+    constexpr unsigned memalignVersion = 5;
+    constexpr unsigned freeDefiniteSizeVersion = 6;
+    constexpr unsigned typedMallocVersion = 15;
+
+    // Newest zone layout whose allocation entry points are all hooked. A zone
+    // with a newer one may have entry points we don't see, so the audit of a
+    // process that has one is reported as incomplete.
+   #if TOWELHOST_AUDIT_TYPED_MALLOC
+    constexpr unsigned newestCoveredVersion = typedMallocVersion;
+   #else
+    constexpr unsigned newestCoveredVersion = typedMallocVersion - 1;
+   #endif
+
+    constexpr int maxZones = 16;
+    ZoneFunctions zoneFunctions[maxZones];
+    int numZones = 0;
+
+    const ZoneFunctions& getOriginal(malloc_zone_t* zone) noexcept
+    {
+        for (int i = 0; i < numZones; ++i)
+            if (zoneFunctions[i].zone == zone)
+                return zoneFunctions[i];
+
+        jassertfalse;
+        return zoneFunctions[0];
+    }
+}
+
+// Forwarders so the hooks can stay in the class's private interface
+struct RealtimeAuditorZoneHooks
+{
+    static void* hookedMalloc(malloc_zone_t* zone, size_t size)
+    {
+        RealtimeAuditor::recordAllocation(size, false);
+        return getOriginal(zone).malloc(zone, size);
+    }
+
+    static void* hookedCalloc(malloc_zone_t* zone, size_t count, size_t size)
+    {
+        RealtimeAuditor::recordAllocation(count * size, false);
+        return getOriginal(zone).calloc(zone, count, size);
+    }
+
+    static void* hookedValloc(malloc_zone_t* zone, size_t size)
+    {
+        RealtimeAuditor::recordAllocation(size, false);
+        return getOriginal(zone).valloc(zone, size);
+    }
+
+    static void* hookedRealloc(malloc_zone_t* zone, void* ptr, size_t size)
+    {
+        RealtimeAuditor::recordAllocation(size, false);
+        return getOriginal(zone).realloc(zone, ptr, size);
+    }
+
+    static void* hookedMemalign(malloc_zone_t* zone, size_t alignment, size_t size)
+    {
+        RealtimeAuditor::recordAllocation(size, false);
+        return getOriginal(zone).memalign(zone, alignment, size);
+    }
+
+    static void hookedFree(malloc_zone_t* zone, void* ptr)
+    {
+        if (ptr != nullptr)
+            RealtimeAuditor::recordAllocation(0, true);
+
+        getOriginal(zone).free(zone, ptr);
+    }
+
+    static void hookedFreeDefiniteSize(malloc_zone_t* zone, void* ptr, size_t size)
+    {
+        if (ptr != nullptr)
+            RealtimeAuditor::recordAllocation(0, true);
+
+        getOriginal(zone).freeDefiniteSize(zone, ptr, size);
+    }
+
+    // A batch counts as one call: it's one trip into the allocator
+    static unsigned hookedBatchMalloc(malloc_zone_t* zone, size_t size, void** results, unsigned numRequested)
+    {
+        RealtimeAuditor::recordAllocation(size * numRequested, false);
+        return getOriginal(zone).batchMalloc(zone, size, results, numRequested);
+    }
+
+    static void hookedBatchFree(malloc_zone_t* zone, void** toBeFreed, unsigned num)
+    {
+        if (num > 0)
+            RealtimeAuditor::recordAllocation(0, true);
+
+        getOriginal(zone).batchFree(zone, toBeFreed, num);
+    }
+
+   #if TOWELHOST_AUDIT_TYPED_MALLOC
+    static void* hookedTypedMalloc(malloc_zone_t* zone, size_t size, malloc_type_id_t type)
+    {
+        RealtimeAuditor::recordAllocation(size, false);
+        return getOriginal(zone).typedMalloc(zone, size, type);
+    }
+
+    static void* hookedTypedCalloc(malloc_zone_t* zone, size_t count, size_t size, malloc_type_id_t type)
+    {
+        RealtimeAuditor::recordAllocation(count * size, false);
+        return getOriginal(zone).typedCalloc(zone, count, size, type);
+    }
+
+    static void* hookedTypedRealloc(malloc_zone_t* zone, void* ptr, size_t size, malloc_type_id_t type)
+    {
+        RealtimeAuditor::recordAllocation(size, false);
+        return getOriginal(zone).typedRealloc(zone, ptr, size, type);
+    }
+
+    static void* hookedTypedMemalign(malloc_zone_t* zone, size_t alignment, size_t size, malloc_type_id_t type)
+    {
+        RealtimeAuditor::recordAllocation(size, false);
+        return getOriginal(zone).typedMemalign(zone, alignment, size, type);
+    }
+   #endif
+
+    static void install()
+    {
+        vm_address_t* zoneAddresses = nullptr;
+        unsigned int count = 0;
+
+        if (malloc_get_all_zones(mach_task_self(), nullptr, &zoneAddresses, &count) != KERN_SUCCESS)
+            count = 0;
+
+        for (unsigned int i = 0; i < count && numZones < maxZones; ++i)
+        {
+            auto* zone = reinterpret_cast<malloc_zone_t*>(zoneAddresses[i]);
+
+            auto& original = zoneFunctions[numZones++];
+            original.zone = zone;
+            original.malloc = zone->malloc;
+            original.calloc = zone->calloc;
+            original.valloc = zone->valloc;
+            original.realloc = zone->realloc;
+            original.memalign = zone->version >= memalignVersion ? zone->memalign : nullptr;
+            original.free = zone->free;
+            original.freeDefiniteSize = zone->version >= freeDefiniteSizeVersion ? zone->free_definite_size : nullptr;
+            original.batchMalloc = zone->batch_malloc;
+            original.batchFree = zone->batch_free;
+           #if TOWELHOST_AUDIT_TYPED_MALLOC
+            if (zone->version >= typedMallocVersion)
+            {
+                original.typedMalloc = zone->malloc_type_malloc;
+                original.typedCalloc = zone->malloc_type_calloc;
+                original.typedRealloc = zone->malloc_type_realloc;
+                original.typedMemalign = zone->malloc_type_memalign;
+            }
+           #endif
+
+            // Recent systems keep the zone's function table read-only
+            const bool isProtected = zone->version >= 8;
+            if (isProtected)
+                vm_protect(mach_task_self(), (vm_address_t) zone, sizeof(malloc_zone_t), 0, VM_PROT_READ | VM_PROT_WRITE);
+
+            zone->malloc = hookedMalloc;
+            zone->calloc = hookedCalloc;
+            zone->valloc = hookedValloc;
+            zone->realloc = hookedRealloc;
+            if (original.memalign != nullptr)
+                zone->memalign = hookedMemalign;
+            zone->free = hookedFree;
+            if (original.freeDefiniteSize != nullptr)
+                zone->free_definite_size = hookedFreeDefiniteSize;
+            if (original.batchMalloc != nullptr)
+                zone->batch_malloc = hookedBatchMalloc;
+            if (original.batchFree != nullptr)
+                zone->batch_free = hookedBatchFree;
+           #if TOWELHOST_AUDIT_TYPED_MALLOC
+            if (original.typedMalloc != nullptr)
+                zone->malloc_type_malloc = hookedTypedMalloc;
+            if (original.typedCalloc != nullptr)
+                zone->malloc_type_calloc = hookedTypedCalloc;
+            if (original.typedRealloc != nullptr)
+                zone->malloc_type_realloc = hookedTypedRealloc;
+            if (original.typedMemalign != nullptr)
+                zone->malloc_type_memalign = hookedTypedMemalign;
+           #endif
+
+            if (isProtected)
+                vm_protect(mach_task_self(), (vm_address_t) zone, sizeof(malloc_zone_t), 0, VM_PROT_READ);
+        }
+    }
+
+    // What the hooks can't see: zones registered since install() or past the
+    // table, and zones newer than the layout this build knows
+    static juce::StringArray findCoverageGaps()
+    {
+        juce::StringArray gaps;
+        vm_address_t* zoneAddresses = nullptr;
+        unsigned int count = 0;
+
+        if (malloc_get_all_zones(mach_task_self(), nullptr, &zoneAddresses, &count) != KERN_SUCCESS)
+        {
+            gaps.add("Could not list the malloc zones to check the hooks");
+            return gaps;
+        }
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            auto* zone = reinterpret_cast<malloc_zone_t*>(zoneAddresses[i]);
+            const char* name = malloc_get_zone_name(zone);
+            const auto zoneName = juce::String(name != nullptr ? name : "unnamed");
+
+            bool hooked = false;
+            for (int z = 0; z < numZones && !hooked; ++z)
+                hooked = zoneFunctions[z].zone == zone;
+
+            if (!hooked)
+                gaps.add("Malloc zone \"" + zoneName + "\" isn't hooked (registered after auditing started, or past the first "
+                         + juce::String(maxZones) + ")");
+            else if (zone->version > newestCoveredVersion)
+            {
+                gaps.add("Malloc zone \"" + zoneName + "\" is version " + juce::String(zone->version)
+                         + "; entry points newer than version " + juce::String(newestCoveredVersion) + " aren't hooked");
+            }
+        }
+
+        return gaps;
+    }
+};
+#endif
+
+namespace
+{
+    juce::StringArray findCoverageGaps()
+    {
+       #if JUCE_MAC
+        return RealtimeAuditorZoneHooks::findCoverageGaps();
+       #else
+        return { "Allocator hooks are only available on macOS; only waits were measured" };
+       #endif
+    }
+}
+
+//==============================================================================
+void RealtimeAuditor::enable()
+{
+    if (auditEnabled.load())
+        return;
+
+    pthread_key_create(&scopeKey, nullptr);
+
+   #if JUCE_MAC
+    RealtimeAuditorZoneHooks::install();
+   #else
+    DBG("RealtimeAuditor: allocator hooks are only available on macOS, measuring waits only");
+   #endif
+
+    auditEnabled.store(true);
+}
+
+bool RealtimeAuditor::isEnabled() noexcept
+{
+    return auditEnabled.load(std::memory_order_relaxed);
+}
+
+RealtimeAuditor::ScopedProcessBlock::ScopedProcessBlock() noexcept
+{
+    if (!isEnabled())
+        return;
+
+    active = true;
+    previous = pthread_getspecific(scopeKey);
+    startTicks = juce::Time::getHighResolutionTicks();
+    startCpuSeconds = getThreadCpuSeconds();
+    pthread_setspecific(scopeKey, this);
+}
+
+RealtimeAuditor::ScopedProcessBlock::~ScopedProcessBlock() noexcept
+{
+    if (!active)
+        return;
+
+    pthread_setspecific(scopeKey, previous);
+
+    const double wallSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    const double offCpuSeconds = wallSeconds - (getThreadCpuSeconds() - startCpuSeconds);
+
+    blocksAudited.fetch_add(1, std::memory_order_relaxed);
+
+    if (allocations > 0)
+    {
+        blocksWithAllocations.fetch_add(1, std::memory_order_relaxed);
+        storeMax(maxAllocationsPerBlock, allocations);
+    }
+
+    if (offCpuSeconds > waitThresholdSeconds)
+    {
+        waitCount.fetch_add(1, std::memory_order_relaxed);
+        addTo(totalWaitSeconds, offCpuSeconds);
+        storeMax(maxWaitSeconds, offCpuSeconds);
+    }
+}
+
+void RealtimeAuditor::recordAllocation(size_t bytes, bool isFree) noexcept
+{
+    auto* scope = static_cast<ScopedProcessBlock*>(pthread_getspecific(scopeKey));
+
+    if (scope == nullptr || scope->inHook)
+        return;
+
+    scope->inHook = true;
+
+    if (isFree)
+    {
+        freeCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        ++scope->allocations;
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add((juce::int64) bytes, std::memory_order_relaxed);
+        recordStack(bytes);
+    }
+
+    scope->inHook = false;
+}
+
+void RealtimeAuditor::recordStack(size_t bytes) noexcept
+{
+    void* frames[maxFrames + framesToSkip];
+    const int numFrames = backtrace(frames, maxFrames + framesToSkip) - framesToSkip;
+
+    if (numFrames <= 0)
+        return;
+
+    // FNV-1a over the return addresses
+    juce::uint64 hash = 14695981039346656037ull;
+    for (int i = 0; i < numFrames; ++i)
+    {
+        hash ^= (juce::uint64) (juce::pointer_sized_uint) frames[i + framesToSkip];
+        hash *= 1099511628211ull;
+    }
+    if (hash == 0)
+        hash = 1;
+
+    for (int probe = 0; probe < maxStacks; ++probe)
+    {
+        auto& record = stacks[(hash + (juce::uint64) probe) % maxStacks];
+        auto existing = record.hash.load(std::memory_order_acquire);
+
+        if (existing == 0 && record.hash.compare_exchange_strong(existing, hash))
+        {
+            std::copy(frames + framesToSkip, frames + framesToSkip + numFrames, record.frames);
+            record.numFrames = numFrames;
+            record.ready.store(true, std::memory_order_release);
+            existing = hash;
+        }
+
+        if (existing == hash)
+        {
+            record.count.fetch_add(1, std::memory_order_relaxed);
+            record.bytes.fetch_add((juce::int64) bytes, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    droppedStacks.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RealtimeAuditor::setWaitFailThreshold(double seconds)
+{
+    waitFailThresholdSeconds.store(juce::jmax(0.0, seconds));
+}
+
+bool RealtimeAuditor::isComplete()
+{
+    return findCoverageGaps().isEmpty();
+}
+
+bool RealtimeAuditor::hasViolations()
+{
+    const double waitFailThreshold = waitFailThresholdSeconds.load();
+
+    return allocationCount.load() > 0 || freeCount.load() > 0
+        || (waitFailThreshold > 0.0 && maxWaitSeconds.load() > waitFailThreshold);
+}
+
+juce::String RealtimeAuditor::createReport()
+{
+    const auto blocks = blocksAudited.load();
+    const auto allocations = allocationCount.load();
+    const auto waits = waitCount.load();
+
+    juce::String report;
+    report << "=== Realtime Audit ===\n"
+           << "Blocks audited: " << blocks << "\n"
+           << "Blocks that allocated: " << blocksWithAllocations.load() << "\n"
+           << "Allocations: " << allocations << " (" << allocatedBytes.load() << " bytes)"
+           << ", per block: " << juce::String(blocks > 0 ? (double) allocations / (double) blocks : 0.0, 3)
+           << ", max in one block: " << maxAllocationsPerBlock.load() << "\n"
+           << "Frees: " << freeCount.load() << "\n";
+
+    const double waitFailThreshold = waitFailThresholdSeconds.load();
+    report << "\nWaits (inferred from wall-clock vs thread CPU time, no call stacks; includes preemption):\n"
+           << "Blocks > " << juce::String(waitThresholdSeconds * 1000.0, 1) << " ms off-CPU: " << waits
+           << ", total " << juce::String(totalWaitSeconds.load() * 1000.0, 2) << " ms"
+           << ", max " << juce::String(maxWaitSeconds.load() * 1000.0, 2) << " ms\n"
+           << (waitFailThreshold > 0.0 ? "Waits longer than " + juce::String(waitFailThreshold * 1000.0, 2) + " ms fail the audit\n"
+                                       : juce::String("Waits don't affect the result (see --audit-fail-on-wait)\n"));
+
+    juce::Array<const StackRecord*> recorded;
+    for (auto& record : stacks)
+        if (record.ready.load(std::memory_order_acquire))
+            recorded.add(&record);
+
+    std::sort(recorded.begin(), recorded.end(),
+              [](const StackRecord* a, const StackRecord* b) { return a->count.load() > b->count.load(); });
+
+    const int maxStacksToShow = 10;
+    for (int i = 0; i < juce::jmin(maxStacksToShow, recorded.size()); ++i)
+    {
+        const auto& record = *recorded.getUnchecked(i);
+        report << "\n--- Allocation stack #" << (i + 1) << ": " << record.count.load() << " call(s), "
+               << record.bytes.load() << " bytes ---\n";
+
+        if (auto** symbols = backtrace_symbols(record.frames, record.numFrames))
+        {
+            for (int f = 0; f < record.numFrames; ++f)
+                report << symbols[f] << "\n";
+
+            ::free(symbols);
+        }
+    }
+
+    if (recorded.size() > maxStacksToShow)
+        report << "\n(" << (recorded.size() - maxStacksToShow) << " more distinct stack(s) not shown)\n";
+
+    if (droppedStacks.load() > 0)
+        report << "(" << droppedStacks.load() << " allocation(s) not attributed, stack table full)\n";
+
+    // Allocations the hooks can't see would pass silently, so a gap is never a clean result
+    const auto gaps = findCoverageGaps();
+    if (!gaps.isEmpty())
+        report << "\nCoverage gaps (allocations there aren't counted):\n  " << gaps.joinIntoString("\n  ") << "\n";
+
+    report << "\nResult: " << (hasViolations() ? "FAIL" : (gaps.isEmpty() ? "PASS" : "INCOMPLETE")) << "\n";
+    return report;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Audit mode for the hosted plugin's processBlock (--audit).
+//
+// While a thread is inside a ScopedProcessBlock, every call into the malloc
+// zones is counted and its call stack recorded, and time the thread spent
+// off the CPU (waiting on a lock, doing I/O or being preempted) is measured
+// by comparing wall-clock time with thread CPU time. Outside processBlock
+// the hooks only check a thread-specific pointer and fall through.
+//
+// Waits are inferred from timing, with no call stack, and ordinary preemption
+// looks the same as a lock wait. So they're reported separately and only fail
+// the audit when a threshold has been set.
+//
+// Every allocating and freeing entry point of each zone is hooked, including
+// batch, sized-free and (with the macOS 14 SDK) typed allocation. Anything the
+// hooks can't see makes the result INCOMPLETE rather than PASS.
+//
+// The hooks are installed once and stay installed until the process exits.
+// Nothing in the hook path allocates or locks: per-block state lives on the
+// audio thread's stack and call stacks go into a fixed-size table.
+class RealtimeAuditor
+{
+public:
+    // Installs the allocator hooks. Message thread, before audio starts.
+    static void enable();
+    static bool isEnabled() noexcept;
+
+    // Marks the calling thread as inside a plugin's processBlock for the
+    // lifetime of the object. Costs one relaxed load when auditing is off.
+    class ScopedProcessBlock
+    {
+    public:
+        ScopedProcessBlock() noexcept;
+        ~ScopedProcessBlock() noexcept;
+
+    private:
+        friend class RealtimeAuditor;
+
+        bool active{false};
+        bool inHook{false};
+        int allocations{0};
+        void* previous{nullptr};
+        juce::int64 startTicks{0};
+        double startCpuSeconds{0.0};
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedProcessBlock)
+    };
+
+    // Off-CPU time in one block above this counts as a blocking wait
+    static constexpr double waitThresholdSeconds = 0.0002;
+
+    // Waits longer than this fail the audit (0, the default, = waits never fail)
+    static void setWaitFailThreshold(double seconds);
+
+    // True if any block allocated or freed, or waited longer than the fail threshold
+    static bool hasViolations();
+
+    // False if the hooks may have missed allocations: a malloc zone registered
+    // after enable(), more zones than the table holds, or a zone with entry
+    // points this build doesn't know about. Message thread.
+    static bool isComplete();
+
+    // Summary plus the most frequent allocation call stacks (symbolicated here,
+    // so only call this once audio has stopped)
+    static juce::String createReport();
+
+private:
+    friend struct RealtimeAuditorZoneHooks;
+
+    static void recordAllocation(size_t bytes, bool isFree) noexcept;
+    static void recordStack(size_t bytes) noexcept;
+
+    RealtimeAuditor() = delete;
+};
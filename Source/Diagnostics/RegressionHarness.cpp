@@ -0,0 +1,320 @@
+#include "RegressionHarness.h"
+#include "../Audio/AudioEngine.h"
+#include "../PluginHost/PluginLoader.h"
+#include <algorithm>
+
+namespace
+{
+    constexpr double tailSeconds = 1.0;
+
+    double toDecibels(float gain)
+    {
+        return juce::Decibels::gainToDecibels(gain, -200.0f);
+    }
+
+    double percentile(std::vector<double> values, double proportion)
+    {
+        if (values.empty())
+            return 0.0;
+
+        const auto index = (size_t) juce::jlimit(0, (int) values.size() - 1, (int) (proportion * (double) (values.size() - 1) + 0.5));
+        std::nth_element(values.begin(), values.begin() + (std::ptrdiff_t) index, values.end());
+        return values[index];
+    }
+}
+
+RegressionHarness::RegressionHarness(AudioEngine& e, const Settings& s)
+    : engine(e), settings(s)
+{
+}
+
+bool RegressionHarness::run()
+{
+    if (!settings.directory.createDirectory())
+    {
+        summary = "Could not create regression directory: " + settings.directory.getFullPathName();
+        return false;
+    }
+
+    createSignals();
+    results.clear();
+
+    const auto baseline = juce::JSON::parse(getBaselineFile());
+    juce::DynamicObject::Ptr newBaseline = new juce::DynamicObject();
+    newBaseline->setProperty("sampleRate", settings.sampleRate);
+    newBaseline->setProperty("blockSize", settings.blockSize);
+
+    if (!settings.updateReferences && baseline.isObject()
+        && ((double) baseline["sampleRate"] != settings.sampleRate || (int) baseline["blockSize"] != settings.blockSize))
+        PluginLoader::LOG("Regression: baseline was recorded with different render settings");
+
+    juce::AudioBuffer<float> output;
+    std::vector<double> blockTimes;
+
+    for (const auto& signal : signals)
+    {
+        Result result;
+        result.name = signal.name;
+
+        render(signal, output, blockTimes);
+
+        result.medianBlockMs = percentile(blockTimes, 0.5);
+        result.p95BlockMs = percentile(blockTimes, 0.95);
+        result.maxBlockMs = blockTimes.empty() ? 0.0 : *std::max_element(blockTimes.begin(), blockTimes.end());
+
+        auto* timing = new juce::DynamicObject();
+        timing->setProperty("medianBlockMs", result.medianBlockMs);
+        timing->setProperty("p95BlockMs", result.p95BlockMs);
+        newBaseline->setProperty(signal.name, juce::var(timing));
+
+        if (settings.updateReferences)
+        {
+            juce::WavAudioFormat wav;
+            auto file = getGoldenFile(signal.name);
+            file.deleteFile();
+
+            std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(new juce::FileOutputStream(file),
+                                                                                settings.sampleRate,
+                                                                                (unsigned int) output.getNumChannels(),
+                                                                                32, {}, 0));
+            result.recorded = writer != nullptr && writer->writeFromAudioSampleBuffer(output, 0, output.getNumSamples());
+            result.audioPassed = result.cpuPassed = result.recorded;
+            result.message = result.recorded ? "reference recorded" : "could not write " + file.getFullPathName();
+        }
+        else
+        {
+            compareAudio(output, result);
+            compareCpu(baseline[juce::Identifier(signal.name)], result);
+        }
+
+        results.push_back(result);
+    }
+
+    if (settings.updateReferences)
+        getBaselineFile().replaceWithText(juce::JSON::toString(juce::var(newBaseline.get())));
+
+    bool passed = true;
+    summary = "=== Regression: " + settings.directory.getFullPathName() + " ===\n";
+
+    for (const auto& result : results)
+    {
+        passed = passed && result.audioPassed && result.cpuPassed;
+        summary << result.name << ": " << (result.audioPassed && result.cpuPassed ? "PASS" : "FAIL")
+                << " (diff " << juce::String(result.peakDifferenceDb, 1) << " dBFS"
+                << ", median " << juce::String(result.medianBlockMs, 3) << " ms"
+                << ", p95 " << juce::String(result.p95BlockMs, 3) << " ms)"
+                << (result.message.isNotEmpty() ? " - " + result.message : juce::String()) << "\n";
+    }
+
+    summary << "Result: " << (passed ? "PASS" : "FAIL") << "\n";
+
+    writeReport(passed);
+    return passed;
+}
+
+void RegressionHarness::createSignals()
+{
+    signals.clear();
+
+    const double sampleRate = settings.sampleRate;
+    const int twoSeconds = juce::roundToInt(2.0 * sampleRate);
+
+    // Impulse
+    {
+        TestSignal signal{ "impulse", juce::AudioBuffer<float>(1, juce::roundToInt(0.5 * sampleRate)), {} };
+        signal.input.clear();
+        signal.input.setSample(0, 0, 1.0f);
+        signals.push_back(std::move(signal));
+    }
+
+    // Exponential sine sweep, 20 Hz to 20 kHz at -6 dBFS
+    {
+        TestSignal signal{ "sweep", juce::AudioBuffer<float>(1, twoSeconds), {} };
+        const double f0 = 20.0, f1 = juce::jmin(20000.0, sampleRate * 0.45);
+        const double duration = twoSeconds / sampleRate;
+        const double rate = std::log(f1 / f0);
+        auto* data = signal.input.getWritePointer(0);
+
+        for (int i = 0; i < twoSeconds; ++i)
+        {
+            const double t = i / sampleRate;
+            const double phase = juce::MathConstants<double>::twoPi * f0 * duration / rate * (std::exp(t * rate / duration) - 1.0);
+            data[i] = (float) (0.5 * std::sin(phase));
+        }
+
+        signals.push_back(std::move(signal));
+    }
+
+    // White noise at -12 dBFS, fixed seed so it's identical every run
+    {
+        TestSignal signal{ "noise", juce::AudioBuffer<float>(1, twoSeconds), {} };
+        juce::Random random(0x70e1);
+        auto* data = signal.input.getWritePointer(0);
+
+        for (int i = 0; i < twoSeconds; ++i)
+            data[i] = 0.25f * (random.nextFloat() * 2.0f - 1.0f);
+
+        signals.push_back(std::move(signal));
+    }
+
+    // MIDI phrase over silence: an arpeggio with a held chord at the end
+    {
+        TestSignal signal{ "midi", juce::AudioBuffer<float>(1, twoSeconds), {} };
+        signal.input.clear();
+
+        const int step = juce::roundToInt(0.25 * sampleRate);
+        const int notes[] = { 60, 64, 67, 72 };
+
+        for (int i = 0; i < 4; ++i)
+        {
+            signal.midi.addEvent(juce::MidiMessage::noteOn(1, notes[i], (juce::uint8) 100), i * step);
+            signal.midi.addEvent(juce::MidiMessage::noteOff(1, notes[i]), i * step + step / 2);
+        }
+
+        for (auto note : notes)
+        {
+            signal.midi.addEvent(juce::MidiMessage::noteOn(1, note, (juce::uint8) 80), 4 * step);
+            signal.midi.addEvent(juce::MidiMessage::noteOff(1, note), 6 * step);
+        }
+
+        signals.push_back(std::move(signal));
+    }
+}
+
+void RegressionHarness::render(const TestSignal& signal, juce::AudioBuffer<float>& output, std::vector<double>& blockTimes)
+{
+    const int numChannels = settings.numChannels;
+    const int blockSize = settings.blockSize;
+    const int totalSamples = signal.input.getNumSamples() + juce::roundToInt(tailSeconds * settings.sampleRate);
+
+    engine.prepareOffline(settings.sampleRate, blockSize, numChannels);
+
+    output.setSize(numChannels, totalSamples);
+    blockTimes.clear();
+    blockTimes.reserve((size_t) (totalSamples / blockSize + 1));
+
+    juce::AudioBuffer<float> block(numChannels, blockSize);
+    juce::MidiBuffer blockMidi;
+
+    for (int position = 0; position < totalSamples; position += blockSize)
+    {
+        const int numSamples = juce::jmin(blockSize, totalSamples - position);
+        const int inputSamples = juce::jlimit(0, numSamples, signal.input.getNumSamples() - position);
+
+        juce::AudioBuffer<float> view(block.getArrayOfWritePointers(), numChannels, numSamples);
+        view.clear();
+
+        for (int ch = 0; ch < numChannels && inputSamples > 0; ++ch)
+            view.copyFrom(ch, 0, signal.input, 0, position, inputSamples);
+
+        blockMidi.clear();
+        blockMidi.addEvents(signal.midi, position, numSamples, -position);
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        engine.processOffline(view, blockMidi);
+        blockTimes.push_back(juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1000.0);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            output.copyFrom(ch, position, view, ch, 0, numSamples);
+    }
+}
+
+void RegressionHarness::compareAudio(const juce::AudioBuffer<float>& output, Result& result)
+{
+    auto file = getGoldenFile(result.name);
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatReader> reader(wav.createReaderFor(new juce::FileInputStream(file), true));
+
+    if (reader == nullptr)
+    {
+        result.message = "no golden file (run with --regress-update)";
+        return;
+    }
+
+    if ((int) reader->lengthInSamples != output.getNumSamples() || (int) reader->numChannels != output.getNumChannels())
+    {
+        result.message = "golden file has a different length or channel count";
+        return;
+    }
+
+    juce::AudioBuffer<float> difference((int) reader->numChannels, (int) reader->lengthInSamples);
+    reader->read(&difference, 0, difference.getNumSamples(), 0, true, true);
+
+    // difference = output - golden, channel by channel
+    float peak = 0.0f, rms = 0.0f;
+    for (int ch = 0; ch < difference.getNumChannels(); ++ch)
+    {
+        auto* data = difference.getWritePointer(ch);
+        juce::FloatVectorOperations::subtract(data, output.getReadPointer(ch), data, difference.getNumSamples());
+
+        peak = juce::jmax(peak, difference.getMagnitude(ch, 0, difference.getNumSamples()));
+        rms = juce::jmax(rms, difference.getRMSLevel(ch, 0, difference.getNumSamples()));
+    }
+
+    result.peakDifferenceDb = toDecibels(peak);
+    result.rmsDifferenceDb = toDecibels(rms);
+    result.audioPassed = result.peakDifferenceDb <= settings.toleranceDb;
+
+    if (!result.audioPassed)
+        result.message = "output differs from golden file";
+}
+
+void RegressionHarness::compareCpu(const juce::var& baseline, Result& result)
+{
+    if (!baseline.isObject())
+    {
+        result.cpuPassed = true;
+        result.message << (result.message.isNotEmpty() ? ", " : "") << "no CPU baseline";
+        return;
+    }
+
+    const double allowed = 1.0 + settings.cpuTolerancePercent / 100.0;
+    const double baselineMedian = baseline["medianBlockMs"];
+    const double baselineP95 = baseline["p95BlockMs"];
+
+    result.cpuPassed = result.medianBlockMs <= baselineMedian * allowed
+                    && result.p95BlockMs <= baselineP95 * allowed;
+
+    if (!result.cpuPassed)
+        result.message << (result.message.isNotEmpty() ? ", " : "") << "slower than baseline (median "
+                       << juce::String(baselineMedian, 3) << " ms, p95 " << juce::String(baselineP95, 3) << " ms)";
+}
+
+void RegressionHarness::writeReport(bool passed)
+{
+    juce::Array<juce::var> signalResults;
+
+    for (const auto& result : results)
+    {
+        auto* object = new juce::DynamicObject();
+        object->setProperty("name", result.name);
+        object->setProperty("passed", result.audioPassed && result.cpuPassed);
+        object->setProperty("audioPassed", result.audioPassed);
+        object->setProperty("cpuPassed", result.cpuPassed);
+        object->setProperty("recorded", result.recorded);
+        object->setProperty("peakDifferenceDb", result.peakDifferenceDb);
+        object->setProperty("rmsDifferenceDb", result.rmsDifferenceDb);
+        object->setProperty("medianBlockMs", result.medianBlockMs);
+        object->setProperty("p95BlockMs", result.p95BlockMs);
+        object->setProperty("maxBlockMs", result.maxBlockMs);
+        object->setProperty("message", result.message);
+        signalResults.add(juce::var(object));
+    }
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty("passed", passed);
+    report->setProperty("updatedReferences", settings.updateReferences);
+    report->setProperty("sampleRate", settings.sampleRate);
+    report->setProperty("blockSize", settings.blockSize);
+    report->setProperty("numChannels", settings.numChannels);
+    report->setProperty("toleranceDb", settings.toleranceDb);
+    report->setProperty("cpuTolerancePercent", settings.cpuTolerancePercent);
+    report->setProperty("signals", signalResults);
+
+    settings.directory.getChildFile("report.json").replaceWithText(juce::JSON::toString(juce::var(report)));
+}
+
+juce::File RegressionHarness::getGoldenFile(const juce::String& name) const
+{
+    return settings.directory.getChildFile(name + ".wav");
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+
+class AudioEngine;
+
+// Null-test and performance regression check for a plugin update (--regress).
+//
+// Renders a fixed set of test signals (impulse, sweep, noise, MIDI phrase)
+// offline through the engine's processing path, then compares the output
+// against golden WAV files and the per-block CPU time against a stored
+// baseline, both kept in one directory. With updateReferences set, the
+// golden files and baseline are rewritten instead.
+//
+// A JSON report is written to the directory as report.json.
+class RegressionHarness
+{
+public:
+    struct Settings
+    {
+        juce::File directory;
+        bool updateReferences{false};
+        double sampleRate{48000.0};
+        int blockSize{512};
+        int numChannels{2};
+
+        // Largest allowed sample difference from the golden file, in dBFS
+        double toleranceDb{-90.0};
+
+        // Allowed slowdown of the median and 95th percentile block time
+        double cpuTolerancePercent{20.0};
+    };
+
+    RegressionHarness(AudioEngine& engine, const Settings& settings);
+
+    // Renders and checks every signal. Returns true if all of them passed.
+    bool run();
+
+    // One line per signal plus the overall result
+    juce::String getSummary() const { return summary; }
+
+private:
+    struct TestSignal
+    {
+        juce::String name;
+        juce::AudioBuffer<float> input; // Mono, copied to every channel
+        juce::MidiBuffer midi;
+    };
+
+    struct Result
+    {
+        juce::String name;
+        bool audioPassed{false};
+        bool cpuPassed{false};
+        bool recorded{false};
+        juce::String message;
+        double peakDifferenceDb{-200.0};
+        double rmsDifferenceDb{-200.0};
+        double medianBlockMs{0.0};
+        double p95BlockMs{0.0};
+        double maxBlockMs{0.0};
+    };
+
+    void createSignals();
+    void render(const TestSignal& signal, juce::AudioBuffer<float>& output, std::vector<double>& blockTimes);
+    void compareAudio(const juce::AudioBuffer<float>& output, Result& result);
+    void compareCpu(const juce::var& baseline, Result& result);
+    void writeReport(bool passed);
+
+    juce::File getGoldenFile(const juce::String& name) const;
+    juce::File getBaselineFile() const { return settings.directory.getChildFile("baseline.json"); }
+
+    AudioEngine& engine;
+    Settings settings;
+    std::vector<TestSignal> signals;
+    std::vector<Result> results;
+    juce::String summary;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RegressionHarness)
+};
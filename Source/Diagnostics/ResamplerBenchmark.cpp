@@ -0,0 +1,80 @@
+#include "ResamplerBenchmark.h"
+#include "../Audio/SampleRateAdapter.h"
+#include <algorithm>
+#include <vector>
+
+ResamplerBenchmark::ResamplerBenchmark(const Settings& s)
+    : settings(s)
+{
+}
+
+bool ResamplerBenchmark::run()
+{
+    const int blockSize = juce::jmax(1, settings.blockSize);
+    const int numChannels = juce::jmax(1, settings.numChannels);
+    const int numBlocks = juce::jmax(1, (int) (settings.seconds * settings.deviceSampleRate / blockSize));
+    const double blockMs = blockSize * 1000.0 / settings.deviceSampleRate;
+    const int pluginBlockSize = (int) std::ceil(blockSize * settings.internalSampleRate / settings.deviceSampleRate);
+
+    summary = "=== Resampler: " + juce::String(settings.deviceSampleRate, 0) + " Hz -> "
+            + juce::String(settings.internalSampleRate, 0) + " Hz -> " + juce::String(settings.deviceSampleRate, 0)
+            + " Hz, " + juce::String(numChannels) + " channels, " + juce::String(blockSize) + "-sample blocks ===\n";
+
+    juce::AudioBuffer<float> noise(numChannels, blockSize * 16);
+    juce::Random random(1);
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int i = 0; i < noise.getNumSamples(); ++i)
+            noise.setSample(ch, i, random.nextFloat() * 2.0f - 1.0f);
+
+    juce::AudioBuffer<float> block(numChannels, blockSize);
+    juce::MidiBuffer midi;
+    std::vector<double> blockTimes((size_t) numBlocks);
+
+    for (auto quality : { PolyphaseResampler::Quality::Fast, PolyphaseResampler::Quality::Balanced, PolyphaseResampler::Quality::Best })
+    {
+        SampleRateAdapter adapter;
+        auto error = adapter.prepare(numChannels, settings.deviceSampleRate, settings.internalSampleRate,
+                                     pluginBlockSize, blockSize, quality);
+        if (error.isNotEmpty())
+        {
+            summary << "Resampler: " << error << "\n";
+            return false;
+        }
+
+        // Only for the filter figures; the adapter holds its own
+        PolyphaseResampler filter;
+        filter.prepare(1, settings.deviceSampleRate, settings.internalSampleRate, quality, blockSize);
+
+        for (int b = 0; b < numBlocks; ++b)
+        {
+            const int offset = (b % 16) * blockSize;
+            for (int ch = 0; ch < numChannels; ++ch)
+                block.copyFrom(ch, 0, noise, ch, offset, blockSize);
+
+            const auto start = juce::Time::getHighResolutionTicks();
+            adapter.process(block, midi, [](juce::AudioBuffer<float>&, juce::MidiBuffer&) {});
+            blockTimes[(size_t) b] = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1000.0;
+        }
+
+        double totalMs = 0.0;
+        for (auto time : blockTimes)
+            totalMs += time;
+
+        auto sorted = blockTimes;
+        std::nth_element(sorted.begin(), sorted.begin() + (std::ptrdiff_t) (sorted.size() / 2), sorted.end());
+        const double medianMs = sorted[sorted.size() / 2];
+        const double maxMs = *std::max_element(blockTimes.begin(), blockTimes.end());
+
+        summary << PolyphaseResampler::getQualityName(quality).paddedRight(' ', 9)
+                << filter.getTapsPerPhase() << " taps, passband to "
+                << juce::String(filter.getPassbandEdgeHz() / 1000.0, 1) << " kHz, "
+                << juce::String(filter.getStopbandAttenuationDb(), 0) << " dB stopband, +"
+                << adapter.getLatencySamples() << " samples ("
+                << juce::String(adapter.getLatencySamples() * 1000.0 / settings.deviceSampleRate, 2) << " ms) | block median "
+                << juce::String(medianMs * 1000.0, 1) << " us (" << juce::String(medianMs * 100.0 / blockMs, 2) << "%), max "
+                << juce::String(maxMs * 1000.0, 1) << " us, "
+                << juce::String(totalMs > 0.0 ? numBlocks * blockMs / totalMs : 0.0, 0) << "x realtime\n";
+    }
+
+    return true;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Cost of each resampler quality preset (--resampler-bench), measured on the
+// same path the engine uses for --sample-rate: device blocks of noise go
+// through the sample rate adapter to the internal rate and back, with an
+// empty plugin in between. No plugin or audio device is needed.
+//
+// The summary lists, per preset, the filter (taps per phase, passband edge,
+// stopband attenuation), the added latency, and the median and worst time
+// per device block as a share of the block duration.
+class ResamplerBenchmark
+{
+public:
+    struct Settings
+    {
+        double deviceSampleRate{44100.0};
+        double internalSampleRate{48000.0};
+        int blockSize{256};
+        int numChannels{2};
+        double seconds{10.0};
+    };
+
+    explicit ResamplerBenchmark(const Settings& settings);
+
+    // Returns false if the rates can't be converted
+    bool run();
+
+    juce::String getSummary() const { return summary; }
+
+private:
+    Settings settings;
+    juce::String summary;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ResamplerBenchmark)
+};
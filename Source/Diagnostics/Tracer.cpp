@@ -0,0 +1,180 @@
+#include "Tracer.h"
+#include <pthread.h>
+#include <vector>
+
+std::atomic<bool> Tracer::enabled{false};
+
+namespace
+{
+    struct Event
+    {
+        const char* name;
+        juce::int64 start;
+        juce::int64 end;
+        juce::int64 arg;
+    };
+
+    // Allocated by enable() and never freed before exit. A thread owns one
+    // from its first span until it exits.
+    struct ThreadBuffer
+    {
+        explicit ThreadBuffer(int capacity) : events((size_t) capacity) {}
+
+        std::vector<Event> events;
+        std::atomic<juce::uint64> numWritten{0};
+        std::atomic<juce::uint64> ownerFirstEvent{0}; // Earlier events belong to a thread that has exited
+        std::atomic<const char*> name{nullptr};
+        std::atomic<int> threadId{0}; // Small sequential number, easier to read in trace viewers; 0 until first used
+        std::atomic<bool> inUse{false};
+    };
+
+    // Filled by enable() before anything is traced, then never changed, so
+    // it's read from any thread without a lock
+    juce::OwnedArray<ThreadBuffer> threadBuffers;
+    std::atomic<int> nextThreadId{1};
+    std::atomic<int> untracedThreads{0};
+    juce::int64 startTicks = 0;
+
+    // Each thread's ring, in a pthread key rather than a thread_local: the
+    // first access to a thread_local can allocate (macOS sets its storage up
+    // lazily), a key's slot is already there. The key's destructor gives the
+    // ring back when the thread exits.
+    pthread_key_t bufferKey;
+    char refusedMarker; // Stored for a thread that found no free ring, so it doesn't look again
+
+    void releaseThreadBuffer(void* value)
+    {
+        if (value != &refusedMarker)
+            static_cast<ThreadBuffer*>(value)->inUse.store(false, std::memory_order_release);
+    }
+
+    // The calling thread's ring, or nullptr if every ring is taken
+    ThreadBuffer* getThreadBuffer() noexcept
+    {
+        auto* value = pthread_getspecific(bufferKey);
+        if (value == &refusedMarker)
+            return nullptr;
+
+        if (value != nullptr)
+            return static_cast<ThreadBuffer*>(value);
+
+        for (auto* buffer : threadBuffers)
+        {
+            if (buffer->inUse.exchange(true, std::memory_order_acquire))
+                continue;
+
+            buffer->ownerFirstEvent.store(buffer->numWritten.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            buffer->name.store(juce::MessageManager::existsAndIsCurrentThread() ? "Message thread" : nullptr,
+                               std::memory_order_relaxed);
+            buffer->threadId.store(nextThreadId.fetch_add(1), std::memory_order_release);
+            pthread_setspecific(bufferKey, buffer);
+            return buffer;
+        }
+
+        pthread_setspecific(bufferKey, &refusedMarker);
+        untracedThreads.fetch_add(1);
+        return nullptr;
+    }
+}
+
+void Tracer::enable(int numEventsPerThread)
+{
+    if (isEnabled())
+        return;
+
+    // Every thread that traces: message, audio callback, render-ahead, one
+    // multi-mono worker per core, and a few to spare
+    const int eventsPerThread = juce::jmax(1024, numEventsPerThread);
+    const int numBuffers = juce::SystemStats::getNumCpus() + 8;
+    for (int i = 0; i < numBuffers; ++i)
+        threadBuffers.add(new ThreadBuffer(eventsPerThread));
+
+    pthread_key_create(&bufferKey, releaseThreadBuffer);
+
+    startTicks = juce::Time::getHighResolutionTicks();
+    enabled.store(true);
+}
+
+void Tracer::nameCurrentThread(const char* threadName) noexcept
+{
+    if (isEnabled())
+        if (auto* buffer = getThreadBuffer())
+            buffer->name.store(threadName, std::memory_order_relaxed);
+}
+
+void Tracer::record(const char* name, juce::int64 start, juce::int64 end, juce::int64 arg) noexcept
+{
+    auto* buffer = getThreadBuffer();
+    if (buffer == nullptr)
+        return;
+
+    const auto index = buffer->numWritten.load(std::memory_order_relaxed);
+
+    buffer->events[(size_t) (index % buffer->events.size())] = { name, start, end, arg };
+    buffer->numWritten.store(index + 1, std::memory_order_release);
+}
+
+bool Tracer::dump(const juce::File& file)
+{
+    if (!isEnabled())
+        return false;
+
+    juce::TemporaryFile temp(file);
+    {
+        juce::FileOutputStream out(temp.getFile());
+        if (!out.openedOk())
+            return false;
+
+        const double ticksPerMicrosecond = (double) juce::Time::getHighResolutionTicksPerSecond() / 1.0e6;
+        auto toMicroseconds = [ticksPerMicrosecond](juce::int64 ticks) { return (double) (ticks - startTicks) / ticksPerMicrosecond; };
+
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        bool first = true;
+
+        for (auto* buffer : threadBuffers)
+        {
+            const int threadId = buffer->threadId.load(std::memory_order_acquire);
+            if (threadId == 0)
+                continue;
+
+            const auto numWritten = buffer->numWritten.load(std::memory_order_acquire);
+            const auto capacity = (juce::uint64) buffer->events.size();
+
+            // The oldest slots of a full ring may be overwritten while we read, so skip a margin
+            const juce::uint64 margin = numWritten > capacity ? capacity / 16 : 0;
+            const juce::uint64 firstEvent = juce::jmax(buffer->ownerFirstEvent.load(std::memory_order_relaxed),
+                                                       numWritten > capacity ? numWritten - capacity + margin : 0);
+
+            const auto* threadName = buffer->name.load();
+            out << (first ? "" : ",\n")
+                << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << threadId
+                << ",\"args\":{\"name\":"
+                << juce::JSON::toString(threadName != nullptr ? juce::String(threadName)
+                                                              : "Thread " + juce::String(threadId))
+                << "}}";
+            first = false;
+
+            for (auto i = firstEvent; i < numWritten; ++i)
+            {
+                const auto& event = buffer->events[(size_t) (i % capacity)];
+
+                out << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << threadId
+                    << ",\"name\":" << juce::JSON::toString(juce::String(event.name))
+                    << ",\"ts\":" << juce::String(toMicroseconds(event.start), 3)
+                    << ",\"dur\":" << juce::String((double) (event.end - event.start) / ticksPerMicrosecond, 3);
+
+                if (event.arg >= 0)
+                    out << ",\"args\":{\"arg\":" << event.arg << "}";
+
+                out << "}";
+            }
+        }
+
+        out << "\n]}\n";
+    }
+
+    if (untracedThreads.load() > 0)
+        DBG("Tracer: " + juce::String(untracedThreads.load()) + " thread(s) found no free ring and weren't traced");
+
+    return temp.overwriteTargetFileWithTemporary();
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+
+// Low-overhead span tracing (--trace), dumped as Chrome trace-event JSON
+// that opens in Perfetto or chrome://tracing.
+//
+// Each thread records into its own fixed-size ring, so recording a span is
+// two timestamp reads and a few stores with no lock. The rings are allocated
+// by enable(), a few more than there are cores; a thread takes a free one
+// with an atomic exchange the first time it records a span and gives it back
+// when it exits, so the audio threads never lock or allocate. A thread that
+// finds none free isn't traced. Rings keep the most recent events when they
+// fill up.
+//
+//   TRACE_SCOPE("processBlock");            // Span lasting until the end of the scope
+//   TRACE_SCOPE_ARG("processBlock", slot);  // ...with an integer argument
+//
+// Names must be string literals (or otherwise outlive the tracer).
+class Tracer
+{
+public:
+    // Message thread, before anything is traced. Allocates every ring.
+    static void enable(int eventsPerThread = 1 << 16);
+    static bool isEnabled() noexcept { return enabled.load(std::memory_order_relaxed); }
+
+    // Label for the calling thread in the trace; cheap enough to call every callback
+    static void nameCurrentThread(const char* name) noexcept;
+
+    // Writes everything recorded so far, without blocking the threads being
+    // traced. Events being written during the dump may be missing.
+    static bool dump(const juce::File& file);
+
+    class Span
+    {
+    public:
+        explicit Span(const char* spanName, juce::int64 spanArg = -1) noexcept
+        {
+            if (isEnabled())
+            {
+                name = spanName;
+                arg = spanArg;
+                start = juce::Time::getHighResolutionTicks();
+            }
+        }
+
+        ~Span() noexcept { end(); }
+
+        // Ends the span early
+        void end() noexcept
+        {
+            if (name != nullptr)
+            {
+                record(name, start, juce::Time::getHighResolutionTicks(), arg);
+                name = nullptr;
+            }
+        }
+
+    private:
+        const char* name{nullptr};
+        juce::int64 arg{-1};
+        juce::int64 start{0};
+
+        JUCE_DECLARE_NON_COPYABLE(Span)
+    };
+
+private:
+    static void record(const char* name, juce::int64 start, juce::int64 end, juce::int64 arg) noexcept;
+
+    static std::atomic<bool> enabled;
+
+    Tracer() = delete;
+};
+
+#define TRACE_SCOPE(name) const Tracer::Span JUCE_JOIN_MACRO(traceSpan, __LINE__)(name)
+#define TRACE_SCOPE_ARG(name, arg) const Tracer::Span JUCE_JOIN_MACRO(traceSpan, __LINE__)(name, (juce::int64) (arg))
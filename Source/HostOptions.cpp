@@ -0,0 +1,237 @@
+#include "HostOptions.h"
+
+namespace
+{
+    // Returns true if the argument list contains --name or --name=value
+    bool hasOption(const juce::StringArray& args, const juce::String& name)
+    {
+        for (const auto& arg : args)
+            if (arg == "--" + name || arg.startsWith("--" + name + "="))
+                return true;
+        return false;
+    }
+
+    // Returns the value of --name=value, or an empty string if not present
+    juce::String getOptionValue(const juce::StringArray& args, const juce::String& name)
+    {
+        for (const auto& arg : args)
+            if (arg.startsWith("--" + name + "="))
+                return arg.fromFirstOccurrenceOf("=", false, false).unquoted();
+        return {};
+    }
+}
+
+HostOptions HostOptions::fromCommandLine(const juce::String& commandLine)
+{
+    HostOptions options;
+    auto args = juce::StringArray::fromTokens(commandLine, true);
+
+    options.abCompare = hasOption(args, "ab");
+
+    auto crossfade = getOptionValue(args, "crossfade");
+    if (crossfade.isNotEmpty())
+        options.crossfadeMs = juce::jlimit(0.0, 1000.0, crossfade.getDoubleValue());
+
+    if (hasOption(args, "ab-headroom"))
+    {
+        options.inactiveOnlyWithHeadroom = true;
+        auto threshold = getOptionValue(args, "ab-headroom");
+        if (threshold.isNotEmpty())
+            options.headroomThreshold = juce::jlimit(0.0, 1.0, threshold.getDoubleValue());
+    }
+
+    if (hasOption(args, "osc"))
+    {
+        options.oscEnabled = true;
+        auto port = getOptionValue(args, "osc");
+        if (port.isNotEmpty())
+            options.oscPort = port.getIntValue();
+    }
+
+    auto bindAddress = getOptionValue(args, "osc-bind");
+    if (bindAddress.isNotEmpty())
+        options.oscBindAddress = bindAddress;
+
+    auto reply = getOptionValue(args, "osc-reply");
+    if (reply.isNotEmpty())
+    {
+        options.oscReplyHost = reply.upToLastOccurrenceOf(":", false, false);
+        options.oscReplyPort = reply.fromLastOccurrenceOf(":", false, false).getIntValue();
+    }
+
+    auto telemetryRate = getOptionValue(args, "telemetry-hz");
+    if (telemetryRate.isNotEmpty())
+        options.telemetryRateHz = juce::jlimit(0.0, 1000.0, telemetryRate.getDoubleValue());
+
+    auto blockSize = getOptionValue(args, "block-size");
+    if (blockSize.isNotEmpty())
+        options.internalBlockSize = juce::jlimit(0, 16384, blockSize.getIntValue());
+
+    auto coalesce = getOptionValue(args, "coalesce");
+    if (coalesce.isNotEmpty())
+        options.coalesceFactor = juce::jlimit(1, 64, coalesce.getIntValue());
+
+    auto channels = getOptionValue(args, "channels");
+    if (channels.isNotEmpty())
+        options.numChannels = juce::jlimit(1, 64, channels.getIntValue());
+
+    if (hasOption(args, "multi-mono"))
+    {
+        auto channelsPerInstance = getOptionValue(args, "multi-mono");
+        options.multiMonoChannels = channelsPerInstance.isNotEmpty() ? juce::jlimit(1, 2, channelsPerInstance.getIntValue()) : 1;
+    }
+
+    options.coldStart = hasOption(args, "cold-start");
+
+    auto autosave = getOptionValue(args, "autosave");
+    if (autosave.isNotEmpty())
+        options.autosaveSeconds = juce::jmax(0.0, autosave.getDoubleValue());
+
+    auto flightRecorder = getOptionValue(args, "flight-recorder");
+    if (flightRecorder.isNotEmpty())
+        options.flightRecorderSeconds = juce::jlimit(0.0, 120.0, flightRecorder.getDoubleValue());
+
+    if (hasOption(args, "audit"))
+    {
+        options.audit = true;
+        options.auditReportPath = getOptionValue(args, "audit");
+    }
+
+    auto auditWait = getOptionValue(args, "audit-fail-on-wait");
+    if (auditWait.isNotEmpty())
+        options.auditWaitFailMs = juce::jmax(0.0, auditWait.getDoubleValue());
+
+    options.regressionDirectory = getOptionValue(args, "regress");
+    options.regressionUpdate = hasOption(args, "regress-update");
+
+    auto tolerance = getOptionValue(args, "regress-tolerance");
+    if (tolerance.isNotEmpty())
+        options.regressionToleranceDb = juce::jlimit(-200.0, 0.0, tolerance.getDoubleValue());
+
+    auto cpuTolerance = getOptionValue(args, "regress-cpu-tolerance");
+    if (cpuTolerance.isNotEmpty())
+        options.regressionCpuTolerancePercent = juce::jmax(0.0, cpuTolerance.getDoubleValue());
+
+    if (hasOption(args, "measure-latency"))
+    {
+        options.measureLatency = true;
+        auto channels = getOptionValue(args, "measure-latency");
+        if (channels.isNotEmpty())
+        {
+            options.latencyOutputChannel = juce::jmax(0, channels.upToFirstOccurrenceOf(":", false, false).getIntValue() - 1);
+            options.latencyInputChannel = juce::jmax(0, channels.fromFirstOccurrenceOf(":", false, false).getIntValue() - 1);
+        }
+    }
+
+    if (hasOption(args, "probe-buffer"))
+    {
+        options.probeBufferSize = true;
+        auto margin = getOptionValue(args, "probe-buffer");
+        if (margin.isNotEmpty())
+            options.probeSafetyMargin = juce::jlimit(0.0, 0.9, margin.getDoubleValue());
+    }
+
+    auto soak = getOptionValue(args, "probe-soak");
+    if (soak.isNotEmpty())
+        options.probeSoakSeconds = juce::jlimit(0.5, 600.0, soak.getDoubleValue());
+
+    options.showAnalyzer = hasOption(args, "analyzer");
+
+    if (hasOption(args, "trace"))
+    {
+        options.trace = true;
+        options.tracePath = getOptionValue(args, "trace");
+    }
+
+    options.hotList.addTokens(getOptionValue(args, "hotlist"), ",", "\"");
+    options.hotList.trim();
+    options.hotList.removeEmptyStrings();
+
+    options.midiFilePath = getOptionValue(args, "midi");
+    options.renderPath = getOptionValue(args, "render");
+
+    auto renderRate = getOptionValue(args, "render-rate");
+    if (renderRate.isNotEmpty())
+        options.renderSampleRate = juce::jlimit(8000.0, 768000.0, renderRate.getDoubleValue());
+
+    auto renderBlock = getOptionValue(args, "render-block");
+    if (renderBlock.isNotEmpty())
+        options.renderBlockSize = juce::jlimit(1, 16384, renderBlock.getIntValue());
+
+    if (hasOption(args, "daemon"))
+    {
+        options.daemon = true;
+        options.daemonSocketPath = getOptionValue(args, "daemon");
+    }
+
+    auto daemonWorkers = getOptionValue(args, "daemon-workers");
+    if (daemonWorkers.isNotEmpty())
+        options.daemonWorkers = juce::jlimit(1, 64, daemonWorkers.getIntValue());
+
+    options.playFilePath = getOptionValue(args, "play");
+    options.renderAhead = hasOption(args, "render-ahead") || options.playFilePath.isNotEmpty();
+
+    auto aheadMs = getOptionValue(args, "render-ahead");
+    if (aheadMs.isNotEmpty())
+        options.renderAheadMs = juce::jlimit(20.0, 5000.0, aheadMs.getDoubleValue());
+
+    auto aheadBlock = getOptionValue(args, "render-ahead-block");
+    if (aheadBlock.isNotEmpty())
+        options.renderAheadBlockSize = juce::jlimit(64, 16384, aheadBlock.getIntValue());
+
+    if (hasOption(args, "skip-silence"))
+    {
+        options.skipSilence = true;
+        auto tail = getOptionValue(args, "skip-silence");
+        if (tail.isNotEmpty())
+            options.silenceTailSeconds = juce::jlimit(0.0, 60.0, tail.getDoubleValue());
+    }
+
+    auto threshold = getOptionValue(args, "silence-threshold");
+    if (threshold.isNotEmpty())
+        options.silenceThresholdDb = juce::jlimit(-200.0f, 0.0f, threshold.getFloatValue());
+
+    auto internalRate = getOptionValue(args, "sample-rate");
+    if (internalRate.isNotEmpty())
+        options.internalSampleRate = juce::jlimit(8000.0, 768000.0, (double) internalRate.getIntValue());
+
+    auto quality = getOptionValue(args, "resampler");
+    if (quality.isNotEmpty() && !PolyphaseResampler::parseQuality(quality, options.resamplerQuality))
+        DBG("Unknown resampler quality: " + quality);
+
+    options.resamplerBenchmark = hasOption(args, "resampler-bench");
+
+    if (hasOption(args, "virtual-device"))
+    {
+        options.virtualDevice = true;
+        auto format = getOptionValue(args, "virtual-device");
+        if (format.isNotEmpty())
+        {
+            options.virtualSampleRate = juce::jlimit(8000.0, 768000.0, (double) format.upToFirstOccurrenceOf(":", false, false).getIntValue());
+            if (format.contains(":"))
+                options.virtualBufferSize = juce::jlimit(16, 16384, format.fromFirstOccurrenceOf(":", false, false).getIntValue());
+        }
+    }
+
+    auto jitter = getOptionValue(args, "virtual-jitter");
+    if (jitter.isNotEmpty())
+        options.virtualJitterMs = juce::jlimit(0.0, 1000.0, jitter.getDoubleValue());
+
+    auto drop = getOptionValue(args, "virtual-drop");
+    if (drop.isNotEmpty())
+        options.virtualDropProbability = juce::jlimit(0.0, 1.0, drop.getDoubleValue());
+
+    auto seed = getOptionValue(args, "virtual-seed");
+    if (seed.isNotEmpty())
+        options.virtualSeed = seed.getLargeIntValue();
+
+    options.virtualInputPath = getOptionValue(args, "virtual-input");
+    options.virtualOutputPath = getOptionValue(args, "virtual-output");
+    options.virtualLoopback = hasOption(args, "virtual-loopback");
+
+    auto virtualSeconds = getOptionValue(args, "virtual-seconds");
+    if (virtualSeconds.isNotEmpty())
+        options.virtualSeconds = juce::jmax(0.0, virtualSeconds.getDoubleValue());
+
+    return options;
+}
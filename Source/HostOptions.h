@@ -0,0 +1,170 @@
+#pragma once
+#include <JuceHeader.h>
+#include "Audio/PolyphaseResampler.h"
+
+// Options passed on the command line, e.g.
+//   open MyPlugin.app --args --ab --crossfade=30
+// Unknown arguments (such as the -psn_ argument macOS adds) are ignored.
+struct HostOptions
+{
+    // --ab : load a second instance of the plugin for A/B comparison
+    bool abCompare{false};
+
+    // --crossfade=<ms> : length of the A/B switch crossfade
+    double crossfadeMs{20.0};
+
+    // --ab-headroom[=<load>] : only run the inactive instance while the
+    // engine's DSP load is below <load> (0..1)
+    bool inactiveOnlyWithHeadroom{false};
+    double headroomThreshold{0.5};
+
+    // --osc[=<port>] : OSC control server (default port 9000)
+    bool oscEnabled{false};
+    int oscPort{9000};
+
+    // --osc-bind=<address> : interface to listen on, localhost unless overridden
+    juce::String oscBindAddress{"127.0.0.1"};
+
+    // --osc-reply=<host>:<port> : where telemetry is sent (port 0 disables it)
+    juce::String oscReplyHost{"127.0.0.1"};
+    int oscReplyPort{9001};
+
+    // --telemetry-hz=<rate> : telemetry send rate
+    double telemetryRateHz{10.0};
+
+    // --block-size=<samples> : run the plugin at a fixed block size, re-blocking
+    // whatever the driver delivers (adds one block of latency)
+    int internalBlockSize{0};
+
+    // --coalesce=<n> : hand the plugin n device blocks per call
+    int coalesceFactor{1};
+
+    // --channels=<n> : number of device input and output channels to open
+    int numChannels{2};
+
+    // --multi-mono[=<1|2>] : one plugin instance per channel (1) or channel
+    // pair (2), processed in parallel on realtime worker threads
+    int multiMonoChannels{0};
+
+    // --cold-start : ignore the saved session snapshot and rediscover the plugin
+    bool coldStart{false};
+
+    // --autosave=<seconds> : how often the plugin state is checked and, if it
+    // changed, saved for crash recovery (default 30, 0 turns autosave off)
+    double autosaveSeconds{30.0};
+
+    // --flight-recorder=<seconds> : how much device audio and callback timing is
+    // kept for dumping after an overrun, on F or on /towelhost/flight/dump
+    // (default 10, 0 turns the recorder off)
+    double flightRecorderSeconds{10.0};
+
+    // --audit[=<report file>] : count allocations and blocking waits inside the
+    // plugin's processBlock, report them at exit and exit with code 1 if it allocated
+    // --audit-fail-on-wait=<ms> : also exit with code 1 if a block spent longer
+    // than <ms> off the CPU (off by default: preemption looks the same)
+    bool audit{false};
+    juce::String auditReportPath;
+    double auditWaitFailMs{0.0};
+
+    // --regress=<dir> : render the test signals offline, compare them with the
+    // golden files and CPU baseline in <dir>, then quit (exit code 1 on failure)
+    // --regress-update : record new golden files and baseline instead
+    // --regress-tolerance=<dBFS> : largest allowed sample difference
+    // --regress-cpu-tolerance=<percent> : allowed block-time slowdown
+    juce::String regressionDirectory;
+    bool regressionUpdate{false};
+    double regressionToleranceDb{-90.0};
+    double regressionCpuTolerancePercent{20.0};
+
+    // --measure-latency[=<output>:<input>] : once audio is running, measure the
+    // round-trip latency from a device output to a looped-back input (1-based,
+    // default 1:1) and log it next to the reported latencies
+    bool measureLatency{false};
+    int latencyOutputChannel{0};
+    int latencyInputChannel{0};
+
+    // --probe-buffer[=<margin>] : find the smallest stable buffer size for this
+    // plugin, keeping <margin> (0..0.9, default 0.3) of each block as headroom,
+    // and remember it for later launches
+    // --probe-soak=<seconds> : how long each buffer size is tested
+    bool probeBufferSize{false};
+    double probeSafetyMargin{0.3};
+    double probeSoakSeconds{5.0};
+
+    // --analyzer : show the spectrum/scope overlay on top of the plugin's editor
+    // at startup (toggle with S); plugins without an editor always get it
+    bool showAnalyzer{false};
+
+    // --trace[=<file>] : record a timeline of plugin loading and audio processing,
+    // written as Chrome trace JSON at exit, on T, or on /towelhost/trace/dump
+    bool trace{false};
+    juce::String tracePath;
+
+    // --hotlist=<name>,<name>... : preload these plugins (found the same way as
+    // the app's own plugin) after startup and switch between them with 1-9, Tab
+    // or the Plugins menu; idle ones are suspended
+    juce::StringArray hotList;
+
+    // --midi=<file> : play a Standard MIDI File into the plugin on a loop
+    // --render=<file.wav> : render the --midi file offline instead, log the
+    // block timings and quit (exit code 1 on failure)
+    // --render-rate=<Hz>, --render-block=<samples> : offline render settings
+    juce::String midiFilePath;
+    juce::String renderPath;
+    double renderSampleRate{48000.0};
+    int renderBlockSize{512};
+
+    // --daemon[=<socket>] : keep the plugin loaded and render jobs sent over a
+    // Unix socket (default <data directory>/<PluginName>.sock) instead of playing
+    // --daemon-workers=<n> : number of instances rendering in parallel
+    bool daemon{false};
+    juce::String daemonSocketPath;
+    int daemonWorkers{2};
+
+    // --play=<file> : loop an audio file into the plugin instead of the device input
+    // --render-ahead[=<ms>] : run the plugin on a background thread <ms> (default
+    // 300) ahead of the device on the file and/or --midi source; implied by --play
+    // --render-ahead-block=<samples> : block size the background thread renders in
+    juce::String playFilePath;
+    bool renderAhead{false};
+    double renderAheadMs{300.0};
+    int renderAheadBlockSize{2048};
+
+    // --skip-silence[=<seconds>] : stop calling the plugin while its input is
+    // silent and its tail has rung out; <seconds> (default 2) stands in for
+    // plugins that report no tail
+    // --silence-threshold=<dBFS> : level counted as silence (default -120)
+    bool skipSilence{false};
+    double silenceTailSeconds{2.0};
+    float silenceThresholdDb{-120.0f};
+
+    // --sample-rate=<Hz> : run the plugin at this rate whatever the device rate,
+    // resampling in both directions (adds a fixed latency)
+    // --resampler=<fast|balanced|best> : resampler quality (default balanced)
+    // --resampler-bench : log the cost of each resampler quality and quit
+    double internalSampleRate{0.0};
+    PolyphaseResampler::Quality resamplerQuality{PolyphaseResampler::Quality::Balanced};
+    bool resamplerBenchmark{false};
+
+    // --virtual-device[=<rate>:<buffer>] : run on a simulated device driven by a
+    // timer thread instead of audio hardware (default 48000:256, --channels wide)
+    // --virtual-jitter=<ms> : delay each callback by up to <ms> at random
+    // --virtual-drop=<0..1> : chance that a callback is missed (counted as an xrun)
+    // --virtual-seed=<n> : seed for the jitter and drops, so a run repeats exactly
+    // --virtual-input=<file> : loop an audio file into the device inputs
+    // --virtual-output=<file.wav> : record the device outputs
+    // --virtual-loopback : feed the outputs back to the inputs one buffer later
+    // --virtual-seconds=<s> : quit after <s> seconds and log the timing summary
+    bool virtualDevice{false};
+    double virtualSampleRate{48000.0};
+    int virtualBufferSize{256};
+    double virtualJitterMs{0.0};
+    double virtualDropProbability{0.0};
+    juce::int64 virtualSeed{1};
+    juce::String virtualInputPath;
+    juce::String virtualOutputPath;
+    bool virtualLoopback{false};
+    double virtualSeconds{0.0};
+
+    static HostOptions fromCommandLine(const juce::String& commandLine);
+};
@@ -1,10 +1,44 @@
 #include <JuceHeader.h>
 #include "PluginHost/PluginLoader.h"
 #include "Audio/AudioEngine.h"
+#include "Audio/BufferSizeProber.h"
+#include "HostOptions.h"
+#include "Remote/OscControlServer.h"
+#include "Remote/RenderDaemon.h"
+#include "PluginHost/ParameterLink.h"
+#include "PluginHost/ParameterRegistry.h"
+#include "PluginHost/SessionSnapshot.h"
+#include "PluginHost/StateAutosaver.h"
+#include "Diagnostics/MidiFileRenderer.h"
+#include "Diagnostics/RealtimeAuditor.h"
+#include "Diagnostics/RegressionHarness.h"
+#include "Diagnostics/ResamplerBenchmark.h"
+#include "Diagnostics/Tracer.h"
+#include "UI/AnalyzerComponent.h"
+
+// Where --trace writes the timeline: the file given, or <PluginName>-trace.json
+// next to the session snapshots
+static juce::File getTraceFile(const HostOptions& options)
+{
+    if (options.tracePath.isNotEmpty())
+        return juce::File::getCurrentWorkingDirectory().getChildFile(options.tracePath);
+
+    return PluginLoader::getDataDirectory().getChildFile(PluginLoader::getExecutableName() + "-trace.json");
+}
+
+static void writeTrace(const juce::File& file)
+{
+    if (Tracer::dump(file))
+        PluginLoader::LOG("Trace written to " + file.getFullPathName());
+    else
+        PluginLoader::LOG("Could not write trace to " + file.getFullPathName());
+}
 
 // Make MainComponent listen to its children (specifically the plugin editor)
 class MainComponent : public juce::Component,
-                      public juce::ComponentListener // Add listener inheritance
+                      public juce::ComponentListener, // Add listener inheritance
+                      private juce::Timer,
+                      private juce::MenuBarModel
 {
 public:
     enum class LoadStatus {
@@ -15,21 +49,60 @@ public:
     };
 
     // Constructor: Set initial state and try loading based on executable name
-    MainComponent()
+    explicit MainComponent(const HostOptions& hostOptions)
+        : options(hostOptions), showAnalyzerOverlay(hostOptions.showAnalyzer)
     {
+        const auto startupStart = juce::Time::getMillisecondCounterHiRes();
+
         // Default size only if no plugin/editor loads
         setSize(400, 200);
-        audioEngine.initialize();
-        status = LoadStatus::NoPlugin;
+        setWantsKeyboardFocus(true);
+
+        // Headless and independent of any plugin
+        if (options.resamplerBenchmark)
+        {
+            runResamplerBenchmark();
+            return;
+        }
 
         // Use the static method from PluginLoader directly
         auto executableName = PluginLoader::getExecutableName();
+        const bool hasPluginName = !executableName.isEmpty() && !executableName.equalsIgnoreCase("TowelHost");
+
+        // Warm start: reuse the discovery results and device setup from the last run.
+        // Regression runs always start from the plugin's default state.
+        const bool isRegressionRun = options.regressionDirectory.isNotEmpty();
+        if (hasPluginName && !options.coldStart && !isRegressionRun)
+            loadSessionSnapshot(executableName);
+
+        if (warmStart != nullptr && warmStart->deviceState != nullptr)
+            audioEngine.setSavedDeviceState(std::move(warmStart->deviceState));
+
+        audioEngine.setNumChannels(options.numChannels, options.numChannels);
+        if (options.virtualDevice)
+            useVirtualDevice();
+        audioEngine.initialize();
+        audioEngine.setInternalBlockSize(options.internalBlockSize);
+        audioEngine.setBlockCoalescing(options.coalesceFactor);
+        audioEngine.setCrossfadeLength(options.crossfadeMs);
+        audioEngine.setRunInactiveOnlyWithHeadroom(options.inactiveOnlyWithHeadroom, options.headroomThreshold);
+        audioEngine.setSilenceSkipping(options.skipSilence, options.silenceTailSeconds, options.silenceThresholdDb);
+        audioEngine.setInternalSampleRate(options.internalSampleRate, options.resamplerQuality);
+        startFlightRecorder();
+        status = LoadStatus::NoPlugin;
+
+        if (options.oscEnabled)
+            startOscServer();
 
         // Skip loading if running as the default "TowelHost" name
-        if (!executableName.isEmpty() && !executableName.equalsIgnoreCase("TowelHost"))
+        if (hasPluginName)
         {
             DBG("Running as renamed plugin host for: " + executableName);
             loadPluginFromName(executableName);
+
+            PluginLoader::LOG("Startup (" + juce::String(warmStart != nullptr ? "warm" : "cold") + "): "
+                              + juce::String(juce::Time::getMillisecondCounterHiRes() - startupStart, 1) + " ms");
+            warmStart = nullptr;
         }
         else if (executableName.equalsIgnoreCase("TowelHost"))
         {
@@ -47,17 +120,43 @@ public:
     // Destructor: Clean up resources in reverse order
     ~MainComponent() override
     {
-        // Remove listener *before* destroying the editor
-        if (pluginEditor != nullptr)
-        {
-            pluginEditor->removeComponentListener(this);
-            DBG("Removed ComponentListener from plugin editor.");
-        }
+        saveSessionSnapshot();
+        stopAutosave();
+        stopTimer();
+       #if JUCE_MAC
+        if (!hotListPlugins.isEmpty())
+            juce::MenuBarModel::setMacMainMenu(nullptr);
+       #endif
+        analyzer = nullptr;
+        oscServer = nullptr; // No more remote commands
+        bufferSizeProber = nullptr;
+        renderDaemon = nullptr; // Waits for running jobs
+        daemonInstances.clear();
 
         audioEngine.stop(); // Stop audio processing first
-        pluginEditor = nullptr; // Destroy editor component
-        audioEngine.setProcessor(nullptr); // Unlink processor from audio engine
-        loadedPlugin = nullptr; // Destroy plugin instance
+
+        if (auto* renderAhead = audioEngine.getRenderAhead())
+            PluginLoader::LOG("Render-ahead: at most " + juce::String(renderAhead->getMaxAheadUsedMs(), 1) + " of "
+                              + juce::String(renderAhead->getAheadMs(), 0) + " ms used, "
+                              + juce::String(renderAhead->getUnderrunCount()) + " underrun(s)");
+        if (options.virtualDevice)
+            PluginLoader::LOG(audioEngine.getVirtualDeviceSummary() + ", engine xruns "
+                              + juce::String(audioEngine.getEngineXRunCount()));
+        if (options.skipSilence)
+            PluginLoader::LOG("Silence skipping: " + juce::String(audioEngine.getSkippedBlockCount()) + " of "
+                              + juce::String(audioEngine.getSlotBlockCount()) + " plugin blocks skipped");
+        destroyEditor(); // Remove listener and destroy editor component
+        parameterLink = nullptr;
+        for (auto& registry : parameterRegistries)
+            registry = nullptr;
+        audioEngine.setMultiMonoProcessors({}, 0); // Unlink processors from audio engine
+        for (int slot = 1; slot < AudioEngine::maxSlots; ++slot)
+            audioEngine.setSlotProcessor(slot, nullptr);
+        audioEngine.setProcessor(nullptr);
+        multiMonoCopies.clear(); // Destroy plugin instances
+        hotListPlugins.clear();
+        comparisonPlugin = nullptr;
+        loadedPlugin = nullptr;
     }
 
     // Paint: Draw status messages only if no editor is active
@@ -84,7 +183,8 @@ public:
                     break;
 
                 case LoadStatus::LoadedNoEditor:
-                    message = "Plugin loaded successfully but has no editor interface.";
+                    message = renderDaemon != nullptr ? "Render daemon: " + juce::String(renderDaemon->getNumWorkers()) + " instance(s) ready."
+                                                      : "Plugin loaded successfully but has no editor interface.";
                     break;
 
                 case LoadStatus::LoadedWithEditor:
@@ -92,8 +192,11 @@ public:
                      g.setColour(juce::Colours::orange);
                     break;
             }
+            // With the analyzer showing, the message moves to a strip above it
+            auto messageArea = analyzer != nullptr ? getLocalBounds().removeFromTop(analyzerMessageHeight) : getLocalBounds();
+
             if (!message.isEmpty())
-                g.drawFittedText(message, getLocalBounds().reduced(10), juce::Justification::centred, maxLines);
+                g.drawFittedText(message, messageArea.reduced(10, analyzer != nullptr ? 2 : 10), juce::Justification::centred, maxLines);
         }
     }
 
@@ -109,6 +212,8 @@ public:
             DBG("MainComponent::resized() - Set editor bounds to: " + getLocalBounds().toString());
         }
 
+        layoutAnalyzer();
+
         // 2. Tell the parent window to adjust its content size to match ours
         updateParentWindowSize();
     }
@@ -143,6 +248,62 @@ public:
         }
     }
 
+    // Shortcuts: S analyzer overlay, T trace dump, F flight recorder dump,
+    // 1-9/Tab hot-list plugins, A/B/Tab comparison instances
+    bool keyPressed(const juce::KeyPress& key) override
+    {
+        // S toggles the analyzer overlay on top of an editor
+        if ((key.isKeyCode('S') || key.isKeyCode('s')) && pluginEditor != nullptr)
+        {
+            showAnalyzerOverlay = !showAnalyzerOverlay;
+            updateAnalyzer();
+            return true;
+        }
+
+        // T writes the trace recorded so far
+        if ((key.isKeyCode('T') || key.isKeyCode('t')) && Tracer::isEnabled())
+        {
+            writeTrace(getTraceFile(options));
+            return true;
+        }
+
+        // F dumps the flight recorder's window
+        if ((key.isKeyCode('F') || key.isKeyCode('f')) && audioEngine.getFlightRecorder().isEnabled())
+        {
+            audioEngine.getFlightRecorder().requestDump();
+            return true;
+        }
+
+        // Hot-list: 1-9 pick a plugin, Tab goes to the next one
+        if (!hotListPlugins.isEmpty())
+        {
+            const auto character = key.getTextCharacter();
+            if (character >= '1' && character <= '9')
+                switchToSlot((int) (character - '1'));
+            else if (key.isKeyCode(juce::KeyPress::tabKey))
+                switchToSlot((audioEngine.getActiveSlot() + 1) % (hotListPlugins.size() + 1));
+            else
+                return false;
+
+            return true;
+        }
+
+        // A/B comparison: A, B or Tab switch between the two instances
+        if (comparisonPlugin == nullptr)
+            return false;
+
+        if (key.isKeyCode('A') || key.isKeyCode('a'))
+            switchToSlot(0);
+        else if (key.isKeyCode('B') || key.isKeyCode('b'))
+            switchToSlot(1);
+        else if (key.isKeyCode(juce::KeyPress::tabKey))
+            switchToSlot(1 - audioEngine.getActiveSlot());
+        else
+            return false;
+
+        return true;
+    }
+
 private:
     // Helper function to update the parent window's size
     void updateParentWindowSize()
@@ -166,11 +327,20 @@ private:
     // Load Plugin Logic
     void loadPluginFromName(const juce::String& name)
     {
+        TRACE_SCOPE("loadPluginFromName");
         DBG("Attempting to load plugin: " + name);
         lastError = ""; // Clear previous error
 
-        // Try loading plugin
-        loadedPlugin = pluginLoader.loadPlugin(name);
+        // Try loading plugin, straight from the saved description on a warm start
+        if (warmStart != nullptr)
+        {
+            loadedPlugin = pluginLoader.loadPluginFromDescription(warmStart->description);
+            if (!loadedPlugin)
+                warmStart = nullptr;
+        }
+
+        if (!loadedPlugin)
+            loadedPlugin = pluginLoader.loadPlugin(name);
 
         if (!loadedPlugin)
         {
@@ -178,32 +348,714 @@ private:
             lastError = pluginLoader.getLastError().isNotEmpty() ? pluginLoader.getLastError() : "Could not find or load \"" + name + "\"";
             DBG(lastError);
             setSize(400, 200); // Ensure default size for error message
+
+            if (options.regressionDirectory.isNotEmpty() || options.renderPath.isNotEmpty())
+            {
+                PluginLoader::LOG((options.renderPath.isNotEmpty() ? "Render: " : "Regression: ") + lastError);
+                juce::JUCEApplicationBase::getInstance()->setApplicationReturnValue(1);
+                juce::MessageManager::callAsync([] { juce::JUCEApplicationBase::quit(); });
+            }
+
             return; // Exit loading process
         }
 
         // --- Plugin loaded successfully ---
         DBG("Plugin instance created: " + loadedPlugin->getName());
-        
-        // Configure buses properly
+        publishParameterRegistry(0);
+        loadedBundle = warmStart != nullptr ? warmStart->bundle : pluginLoader.getLastResolvedFile();
+
+        // The saved state goes in before any copies are made, so they start from it too
+        if (warmStart != nullptr && warmStart->pluginState.getSize() > 0)
+            loadedPlugin->setStateInformation(warmStart->pluginState.getData(), (int) warmStart->pluginState.getSize());
+
+        // Falls back to a single instance if the plugin won't run in mono (or stereo) pieces
+        if (options.multiMonoChannels > 0 && !loadMultiMonoCopies(name))
+            options.multiMonoChannels = 0;
+
+        if (options.multiMonoChannels == 0)
+        {
+            if (warmStart == nullptr || !restoreBusesLayout(*loadedPlugin))
+                configureBuses(*loadedPlugin);
+
+            audioEngine.setProcessor(loadedPlugin.get());
+
+            if (options.abCompare && options.hotList.isEmpty())
+                loadComparisonInstance(name);
+            else if (options.abCompare)
+                PluginLoader::LOG("--ab is ignored with --hotlist");
+        }
+
+        // Headless check: the device is never started
+        if (options.regressionDirectory.isNotEmpty())
+        {
+            status = LoadStatus::LoadedNoEditor;
+            runRegression();
+            return;
+        }
+
+        if (options.renderPath.isNotEmpty())
+        {
+            status = LoadStatus::LoadedNoEditor;
+            runMidiRender();
+            return;
+        }
+
+        if (options.daemon)
+        {
+            status = LoadStatus::LoadedNoEditor;
+            startRenderDaemon(name);
+            return;
+        }
+
+        if (showEditorFor(*loadedPlugin))
+        {
+            if (warmStart != nullptr && warmStart->windowWidth > 0 && warmStart->windowHeight > 0
+                && pluginEditor->isResizable())
+                setSize(warmStart->windowWidth, warmStart->windowHeight);
+
+            startAudio();
+            updateAnalyzer();
+            startAutosave(name);
+            DBG("Plugin loading complete with editor.");
+            return; // Success
+        }
+
+        // --- Plugin loaded, but no editor ---
+        status = LoadStatus::LoadedNoEditor;
+        setSize(600, 360); // Room for the message and the analyzer
+        startAudio(); // Start audio processing anyway
+        updateAnalyzer();
+        startAutosave(name);
+        DBG("Plugin loading complete without editor.");
+        // No listener needed if there's no editor
+    }
+
+    // Renders the regression signals offline, reports and quits
+    void runRegression()
+    {
+        RegressionHarness::Settings settings;
+        settings.directory = juce::File::getCurrentWorkingDirectory().getChildFile(options.regressionDirectory);
+        settings.updateReferences = options.regressionUpdate;
+        settings.numChannels = options.multiMonoChannels > 0 ? juce::jmax(options.numChannels, options.multiMonoChannels)
+                                                             : juce::jmax(loadedPlugin->getTotalNumInputChannels(),
+                                                                          loadedPlugin->getTotalNumOutputChannels(), 1);
+        settings.toleranceDb = options.regressionToleranceDb;
+        settings.cpuTolerancePercent = options.regressionCpuTolerancePercent;
+
+        RegressionHarness harness(audioEngine, settings);
+        const bool passed = harness.run();
+        PluginLoader::LOG(harness.getSummary());
+
+        if (!passed)
+            juce::JUCEApplicationBase::getInstance()->setApplicationReturnValue(1);
+
+        juce::MessageManager::callAsync([] { juce::JUCEApplicationBase::quit(); });
+    }
+
+    // Soak and timing runs without audio hardware
+    void useVirtualDevice()
+    {
+        const auto directory = juce::File::getCurrentWorkingDirectory();
+
+        VirtualDeviceSettings settings;
+        settings.sampleRate = options.virtualSampleRate;
+        settings.bufferSize = options.virtualBufferSize;
+        settings.numInputChannels = options.numChannels;
+        settings.numOutputChannels = options.numChannels;
+        settings.jitterMs = options.virtualJitterMs;
+        settings.dropProbability = options.virtualDropProbability;
+        settings.seed = options.virtualSeed;
+        settings.loopback = options.virtualLoopback;
+        if (options.virtualInputPath.isNotEmpty())
+            settings.inputFile = directory.getChildFile(options.virtualInputPath);
+        if (options.virtualOutputPath.isNotEmpty())
+            settings.outputFile = directory.getChildFile(options.virtualOutputPath);
+
+        audioEngine.useVirtualDevice(settings);
+
+        PluginLoader::LOG("Virtual device: " + juce::String(settings.sampleRate, 0) + " Hz, "
+                          + juce::String(settings.bufferSize) + " samples, jitter up to "
+                          + juce::String(settings.jitterMs, 2) + " ms, drop chance "
+                          + juce::String(settings.dropProbability, 4) + ", seed " + juce::String(settings.seed));
+
+        if (options.virtualSeconds > 0.0)
+            juce::Timer::callAfterDelay(juce::roundToInt(options.virtualSeconds * 1000.0),
+                                        [] { juce::JUCEApplicationBase::quit(); });
+    }
+
+    // Logs the cost of each resampler quality and quits
+    void runResamplerBenchmark()
+    {
+        ResamplerBenchmark::Settings settings;
+        if (options.internalSampleRate > 0.0)
+            settings.internalSampleRate = options.internalSampleRate;
+        if (settings.internalSampleRate == settings.deviceSampleRate)
+            settings.deviceSampleRate = 48000.0;
+
+        ResamplerBenchmark benchmark(settings);
+        if (!benchmark.run())
+            juce::JUCEApplicationBase::getInstance()->setApplicationReturnValue(1);
+        PluginLoader::LOG(benchmark.getSummary());
+
+        juce::MessageManager::callAsync([] { juce::JUCEApplicationBase::quit(); });
+    }
+
+    // Renders the --midi file offline to the --render file, reports and quits
+    void runMidiRender()
+    {
+        MidiFileRenderer::Settings settings;
+        settings.midiFile = juce::File::getCurrentWorkingDirectory().getChildFile(options.midiFilePath);
+        settings.outputFile = juce::File::getCurrentWorkingDirectory().getChildFile(options.renderPath);
+        settings.sampleRate = options.renderSampleRate;
+        settings.blockSize = options.renderBlockSize;
+        settings.numChannels = juce::jmax(loadedPlugin->getTotalNumInputChannels(),
+                                          loadedPlugin->getTotalNumOutputChannels(), 1);
+
+        bool rendered = false;
+        if (options.midiFilePath.isEmpty())
+        {
+            PluginLoader::LOG("Render: --render needs a --midi file");
+        }
+        else
+        {
+            MidiFileRenderer renderer(audioEngine, settings);
+            rendered = renderer.run();
+            PluginLoader::LOG(renderer.getSummary());
+        }
+
+        if (!rendered)
+            juce::JUCEApplicationBase::getInstance()->setApplicationReturnValue(1);
+
+        juce::MessageManager::callAsync([] { juce::JUCEApplicationBase::quit(); });
+    }
+
+    // Daemon mode: the loaded plugin plus further instances, one per worker,
+    // stay resident and render jobs from the socket. The device is never started.
+    void startRenderDaemon(const juce::String& name)
+    {
+        juce::Array<juce::AudioPluginInstance*> instances { loadedPlugin.get() };
+
+        for (int i = 1; i < options.daemonWorkers; ++i)
+        {
+            auto instance = loadAnotherInstance(name);
+            if (!instance)
+            {
+                PluginLoader::LOG("Daemon: could not load instance " + juce::String(i + 1) + ": " + pluginLoader.getLastError());
+                break;
+            }
+
+            configureBuses(*instance);
+            instances.add(instance.get());
+            daemonInstances.add(instance.release());
+        }
+
+        // The workers own the instances from here on
+        audioEngine.setProcessor(nullptr);
+
+        const auto socketFile = options.daemonSocketPath.isNotEmpty()
+                                    ? juce::File::getCurrentWorkingDirectory().getChildFile(options.daemonSocketPath)
+                                    : PluginLoader::getDataDirectory().getChildFile(name + ".sock");
+
+        renderDaemon = std::make_unique<RenderDaemon>(instances);
+        auto error = renderDaemon->start(socketFile);
+
+        if (error.isNotEmpty())
+        {
+            PluginLoader::LOG("Daemon: " + error);
+            renderDaemon = nullptr;
+            juce::JUCEApplicationBase::getInstance()->setApplicationReturnValue(1);
+            juce::MessageManager::callAsync([] { juce::JUCEApplicationBase::quit(); });
+            return;
+        }
+
+        PluginLoader::LOG("Daemon: " + juce::String(renderDaemon->getNumWorkers()) + " worker(s) listening on "
+                          + socketFile.getFullPathName());
+        repaint();
+    }
+
+    void enableRenderAhead()
+    {
+        const auto sourceFile = options.playFilePath.isNotEmpty()
+                                    ? juce::File::getCurrentWorkingDirectory().getChildFile(options.playFilePath)
+                                    : juce::File();
+
+        auto error = audioEngine.enableRenderAhead(sourceFile, options.renderAheadMs, options.renderAheadBlockSize);
+        if (error.isNotEmpty())
+        {
+            PluginLoader::LOG("Render-ahead: " + error);
+            return;
+        }
+
+        PluginLoader::LOG("Render-ahead: " + juce::String(options.renderAheadMs, 0) + " ms ahead in "
+                          + juce::String(options.renderAheadBlockSize) + "-sample blocks"
+                          + (sourceFile != juce::File() ? ", playing " + sourceFile.getFileName() : juce::String()));
+    }
+
+    // Loops the --midi file into the plugin while it runs
+    void playMidiFile()
+    {
+        auto sequence = std::make_unique<MidiFileSequencer>();
+        auto error = sequence->load(juce::File::getCurrentWorkingDirectory().getChildFile(options.midiFilePath));
+
+        if (error.isNotEmpty())
+        {
+            PluginLoader::LOG("MIDI file: " + error);
+            return;
+        }
+
+        PluginLoader::LOG("MIDI file: playing " + sequence->getFileName() + " (" + juce::String(sequence->getNumEvents())
+                          + " events, " + juce::String(sequence->getLengthInSeconds(), 1) + " s, looped)");
+        audioEngine.setMidiSequence(std::move(sequence));
+    }
+
+    // Reads the snapshot for this plugin; keeps it only if the component is unchanged
+    void loadSessionSnapshot(const juce::String& name)
+    {
+        const auto file = SessionSnapshot::getFileFor(name);
+        auto snapshot = std::make_unique<SessionSnapshot>();
+
+        if (!snapshot->load(file))
+            return;
+
+        if (!snapshot->isValidFor(name))
+        {
+            PluginLoader::LOG("Session snapshot is out of date, doing a full load: " + file.getFullPathName());
+            return;
+        }
+
+        warmStart = std::move(snapshot);
+    }
+
+    void saveSessionSnapshot()
+    {
+        if (loadedPlugin == nullptr || !loadedBundle.isDirectory() || options.regressionDirectory.isNotEmpty()
+            || options.renderPath.isNotEmpty() || options.daemon || options.virtualDevice)
+            return;
+
+        const auto saveStart = juce::Time::getMillisecondCounterHiRes();
+        const auto name = PluginLoader::getExecutableName();
+
+        SessionSnapshot snapshot;
+        snapshot.pluginName = name;
+        snapshot.setBundle(loadedBundle);
+        snapshot.description = loadedPlugin->getPluginDescription();
+        snapshot.setBusesLayout(loadedPlugin->getBusesLayout());
+        snapshot.deviceState = audioEngine.createDeviceState();
+        loadedPlugin->getStateInformation(snapshot.pluginState);
+
+        if (pluginEditor != nullptr)
+        {
+            snapshot.windowWidth = getWidth();
+            snapshot.windowHeight = getHeight();
+        }
+
+        if (snapshot.save(SessionSnapshot::getFileFor(name)))
+            PluginLoader::LOG("Saved session snapshot in "
+                              + juce::String(juce::Time::getMillisecondCounterHiRes() - saveStart, 1) + " ms");
+        else
+            PluginLoader::LOG("Could not save session snapshot for " + name);
+    }
+
+    // Applies the bus layout negotiated on the previous run
+    bool restoreBusesLayout(juce::AudioPluginInstance& plugin)
+    {
+        TRACE_SCOPE("restoreBusesLayout");
+        plugin.enableAllBuses();
+
+        if (!plugin.setBusesLayout(warmStart->getBusesLayout()))
+        {
+            DBG("Saved bus layout rejected, negotiating again");
+            return false;
+        }
+
+        return true;
+    }
+
+    // The analyzer fills the window when there's no editor, or overlays the editor when toggled on
+    void updateAnalyzer()
+    {
+        const bool isOverlay = pluginEditor != nullptr;
+        const bool wanted = isOverlay ? showAnalyzerOverlay : status == LoadStatus::LoadedNoEditor;
+
+        if (!wanted)
+        {
+            analyzer = nullptr;
+            repaint();
+            return;
+        }
+
+        if (analyzer == nullptr || analyzerIsOverlay != isOverlay)
+        {
+            analyzer = std::make_unique<AnalyzerComponent>(audioEngine, isOverlay);
+            analyzerIsOverlay = isOverlay;
+            addAndMakeVisible(*analyzer);
+        }
+
+        analyzer->toFront(false);
+        layoutAnalyzer();
+        repaint();
+    }
+
+    void layoutAnalyzer()
+    {
+        if (analyzer == nullptr)
+            return;
+
+        auto bounds = getLocalBounds();
+
+        if (analyzerIsOverlay)
+            analyzer->setBounds(bounds.removeFromBottom(juce::jmax(120, getHeight() / 3)));
+        else
+            analyzer->setBounds(bounds.withTrimmedTop(analyzerMessageHeight));
+    }
+
+    void startAudio()
+    {
+        if (options.midiFilePath.isNotEmpty())
+            playMidiFile();
+
+        if (options.renderAhead)
+            enableRenderAhead();
+
+        audioEngine.start();
+
+        if (options.probeBufferSize)
+            startBufferSizeProbe();
+        else
+            applySavedBufferSize();
+
+        // Give the device a moment to settle before measuring
+        if (options.measureLatency)
+        {
+            juce::Component::SafePointer<MainComponent> safeThis(this);
+            juce::Timer::callAfterDelay(1000, [safeThis]
+            {
+                if (safeThis != nullptr)
+                    safeThis->measureLatency();
+            });
+        }
+
+        const bool resampling = audioEngine.getPluginSampleRate() != audioEngine.getCurrentSampleRate();
+        if (resampling)
+            PluginLoader::LOG("Plugin runs at " + juce::String(audioEngine.getPluginSampleRate(), 0) + " Hz (device "
+                              + juce::String(audioEngine.getCurrentSampleRate(), 0) + " Hz, "
+                              + PolyphaseResampler::getQualityName(options.resamplerQuality) + " resampler)");
+        else if (options.internalSampleRate > 0.0 && !options.renderAhead
+                 && options.internalSampleRate != audioEngine.getCurrentSampleRate())
+            PluginLoader::LOG("Can't resample " + juce::String(audioEngine.getCurrentSampleRate(), 0) + " Hz to "
+                              + juce::String(options.internalSampleRate, 0) + " Hz; plugin runs at the device rate");
+
+        if (audioEngine.getAddedLatencySamples() > 0)
+            PluginLoader::LOG(juce::String(resampling ? "Resampling" : "Block adapter") + " adds "
+                              + juce::String(audioEngine.getAddedLatencySamples())
+                              + " samples of latency (plugin latency: "
+                              + juce::String(loadedPlugin->getLatencySamples()) + " samples)");
+
+        if (!options.hotList.isEmpty() && options.multiMonoChannels == 0)
+        {
+            audioEngine.setSuspendInactiveSlots(true);
+            loadNextHotListPluginAsync();
+        }
+    }
+
+    // Hot-list: the other plugins are created one per message loop turn once the
+    // first one is playing, so the window and audio stay responsive meanwhile.
+    // Each is prepared as it goes into its slot, so switching never stalls.
+    void loadNextHotListPluginAsync()
+    {
+        juce::Component::SafePointer<MainComponent> safeThis(this);
+        juce::MessageManager::callAsync([safeThis]
+        {
+            if (safeThis != nullptr)
+                safeThis->loadNextHotListPlugin();
+        });
+    }
+
+    void loadNextHotListPlugin()
+    {
+        if (hotListLoadIndex >= options.hotList.size())
+            return;
+
+        if (hotListPlugins.size() + 1 >= AudioEngine::maxSlots)
+        {
+            PluginLoader::LOG("Hot-list: only " + juce::String(AudioEngine::maxSlots - 1) + " plugins fit, ignoring the rest");
+            return;
+        }
+
+        const auto name = options.hotList[hotListLoadIndex++];
+        const auto startTime = juce::Time::getMillisecondCounterHiRes();
+        TRACE_SCOPE("Hot-list load");
+
+        if (auto plugin = pluginLoader.loadPlugin(name))
+        {
+            configureBuses(*plugin);
+
+            const int slot = hotListPlugins.size() + 1;
+            audioEngine.setSlotProcessor(slot, plugin.get());
+            hotListPlugins.add(plugin.release());
+
+            PluginLoader::LOG("Hot-list: " + name + " ready in slot " + juce::String(slot + 1) + " ("
+                              + juce::String(juce::Time::getMillisecondCounterHiRes() - startTime, 1) + " ms)");
+
+           #if JUCE_MAC
+            if (hotListPlugins.size() == 1)
+                juce::MenuBarModel::setMacMainMenu(this);
+           #endif
+            menuItemsChanged();
+
+            if (!isTimerRunning())
+                startTimerHz(4); // Active plugin and load in the title bar
+        }
+        else
+        {
+            PluginLoader::LOG("Hot-list: could not load " + name + ": " + pluginLoader.getLastError());
+        }
+
+        loadNextHotListPluginAsync();
+    }
+
+    // The instance in an engine slot: B in A/B mode, otherwise a hot-list plugin
+    juce::AudioPluginInstance* getSlotPlugin(int slot) const
+    {
+        if (slot == 0)
+            return loadedPlugin.get();
+
+        if (comparisonPlugin != nullptr)
+            return slot == 1 ? comparisonPlugin.get() : nullptr;
+
+        return hotListPlugins[slot - 1];
+    }
+
+    // Plugins menu in the menu bar, listing the hot-list
+    juce::StringArray getMenuBarNames() override
+    {
+        return { "Plugins" };
+    }
+
+    juce::PopupMenu getMenuForIndex(int, const juce::String&) override
+    {
+        juce::PopupMenu menu;
+
+        for (int slot = 0; slot <= hotListPlugins.size(); ++slot)
+        {
+            juce::PopupMenu::Item item(getSlotPlugin(slot)->getName());
+            item.itemID = slot + 1;
+            item.isTicked = slot == audioEngine.getActiveSlot();
+            if (slot < 9)
+                item.shortcutKeyDescription = juce::String(slot + 1);
+            menu.addItem(item);
+        }
+
+        return menu;
+    }
+
+    void menuItemSelected(int menuItemID, int) override
+    {
+        switchToSlot(menuItemID - 1);
+    }
+
+    // Switches to the buffer size an earlier --probe-buffer run chose for this plugin and device
+    void applySavedBufferSize()
+    {
+        const int saved = BufferSizeProber::getSavedBufferSize(PluginLoader::getExecutableName(),
+                                                               audioEngine.getCurrentDeviceName(),
+                                                               audioEngine.getCurrentSampleRate());
+
+        if (saved > 0 && saved != audioEngine.getCurrentBufferSize())
+        {
+            PluginLoader::LOG("Using probed buffer size: " + juce::String(saved) + " samples");
+            audioEngine.changeDeviceSetup(0.0, saved, {});
+        }
+    }
+
+    // Offers the newest autosave if the last session didn't quit cleanly, then
+    // starts checking this one. The autosaver only begins after the answer, so
+    // it can't rotate out the file being offered.
+    void startAutosave(const juce::String& name)
+    {
+        if (options.autosaveSeconds <= 0.0 || options.virtualDevice)
+            return;
+
+        autosaver = std::make_unique<StateAutosaver>(*loadedPlugin, name);
+
+        std::shared_ptr<StateAutosaver::Autosave> newest = StateAutosaver::findNewest(name);
+        if (newest == nullptr || newest->pluginName != loadedPlugin->getName())
+        {
+            autosaver->start(options.autosaveSeconds);
+            return;
+        }
+
+        PluginLoader::LOG("Autosave found from a session that didn't quit cleanly: " + newest->file.getFullPathName());
+
+        juce::Component::SafePointer<MainComponent> safeThis(this);
+        juce::AlertWindow::showOkCancelBox(juce::MessageBoxIconType::QuestionIcon, "Restore Autosave",
+                                           "TowelHost didn't quit normally last time. Restore the plugin state autosaved at "
+                                               + newest->time.toString(true, true, true, true) + "?",
+                                           "Restore", "Keep Current", this,
+                                           juce::ModalCallbackFunction::create([safeThis, newest](int result)
+                                           {
+                                               if (safeThis == nullptr || safeThis->autosaver == nullptr)
+                                                   return;
+
+                                               if (result != 0)
+                                                   safeThis->restoreAutosave(*newest);
+
+                                               safeThis->autosaver->start(safeThis->options.autosaveSeconds);
+                                           }));
+    }
+
+    // Every instance of the plugin gets the state, as when it was loaded
+    void restoreAutosave(const StateAutosaver::Autosave& autosave)
+    {
+        const auto& state = autosave.state;
+        loadedPlugin->setStateInformation(state.getData(), (int) state.getSize());
+
+        for (auto* copy : multiMonoCopies)
+            copy->setStateInformation(state.getData(), (int) state.getSize());
+        if (comparisonPlugin != nullptr)
+            comparisonPlugin->setStateInformation(state.getData(), (int) state.getSize());
+
+        PluginLoader::LOG("Restored autosave: " + autosave.file.getFullPathName());
+    }
+
+    // A clean quit leaves nothing to recover: the session snapshot has the state
+    void stopAutosave()
+    {
+        if (autosaver == nullptr)
+            return;
+
+        autosaver->stop();
+        PluginLoader::LOG(autosaver->getSummary());
+        autosaver->discard();
+        autosaver = nullptr;
+    }
+
+    void startFlightRecorder()
+    {
+        const auto directory = PluginLoader::getDataDirectory().getChildFile("FlightRecorder")
+                                   .getChildFile(juce::File::createLegalFileName(PluginLoader::getExecutableName()));
+        audioEngine.setFlightRecorder(options.flightRecorderSeconds, directory);
+        audioEngine.getFlightRecorder().onDump = [](const juce::File& folder, const juce::String& reason)
+        {
+            PluginLoader::LOG("Flight recorder: " + reason + " dump written to " + folder.getFullPathName());
+        };
+    }
+
+    void startBufferSizeProbe()
+    {
+        bufferSizeProber = std::make_unique<BufferSizeProber>(audioEngine, PluginLoader::getExecutableName());
+        bufferSizeProber->onComplete = [this](int bufferSize)
+        {
+            juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::InfoIcon, "Buffer Size Probe",
+                                                   bufferSize > 0 ? "Smallest stable buffer size: " + juce::String(bufferSize) + " samples"
+                                                                  : juce::String("No stable buffer size found, see the log for details."));
+        };
+
+        BufferSizeProber::Settings settings;
+        settings.safetyMargin = options.probeSafetyMargin;
+        settings.soakSeconds = options.probeSoakSeconds;
+        bufferSizeProber->start(settings);
+    }
+
+    void measureLatency()
+    {
+        auto error = audioEngine.measureLatency(options.latencyOutputChannel, options.latencyInputChannel,
+                                                [](const LatencyProbe::Result& result)
+                                                {
+                                                    PluginLoader::LOG(result.toString());
+                                                    juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::InfoIcon,
+                                                                                           "Latency Measurement", result.toString());
+                                                });
+        if (error.isNotEmpty())
+            PluginLoader::LOG("Latency measurement: " + error);
+    }
+
+    void startOscServer()
+    {
+        oscServer = std::make_unique<OscControlServer>(audioEngine);
+        oscServer->onPresetLoad = [this](const juce::File& file) { loadPresetFile(file); };
+        oscServer->onSlotSelect = [this](int slot) { switchToSlot(slot); };
+        oscServer->onTraceDump = [this](const juce::File& file)
+        {
+            if (Tracer::isEnabled())
+                writeTrace(file != juce::File() ? file : getTraceFile(options));
+        };
+
+        auto error = oscServer->start(options.oscPort, options.oscBindAddress,
+                                      options.oscReplyHost, options.oscReplyPort,
+                                      options.telemetryRateHz);
+        if (error.isNotEmpty())
+        {
+            PluginLoader::LOG("OSC: " + error);
+            oscServer = nullptr;
+        }
+    }
+
+    // Makes the slot's registry the one OSC resolves /param/id against and reports from
+    void publishParameterRegistry(int slot)
+    {
+        auto* plugin = getSlotPlugin(slot);
+        if (plugin == nullptr)
+            return;
+
+        // A stale registry is only freed after the server has let go of it
+        auto& registry = parameterRegistries[(size_t) slot];
+        std::unique_ptr<ParameterRegistry> replaced;
+        if (registry == nullptr || &registry->getProcessor() != plugin)
+        {
+            replaced = std::move(registry);
+            registry = std::make_unique<ParameterRegistry>(*plugin);
+        }
+
+        if (oscServer != nullptr)
+            oscServer->setParameterRegistry(registry.get());
+    }
+
+    // Loads a state blob (as written by getStateInformation) into the audible instance
+    void loadPresetFile(const juce::File& file)
+    {
+        auto* plugin = getSlotPlugin(audioEngine.getActiveSlot());
+        if (plugin == nullptr)
+            return;
+
+        juce::MemoryBlock state;
+        if (!file.loadFileAsData(state) || state.getSize() == 0)
+        {
+            PluginLoader::LOG("Could not read preset: " + file.getFullPathName());
+            return;
+        }
+
+        plugin->setStateInformation(state.getData(), (int) state.getSize());
+
+        for (auto* copy : multiMonoCopies)
+            copy->setStateInformation(state.getData(), (int) state.getSize());
+
+        PluginLoader::LOG("Loaded preset: " + file.getFullPathName());
+    }
+
+    // Configure buses properly
+    void configureBuses(juce::AudioPluginInstance& plugin)
+    {
+        TRACE_SCOPE("configureBuses");
         // First enable all buses to allow the plugin to initialize
-        loadedPlugin->enableAllBuses();
-        
+        plugin.enableAllBuses();
+
         // Try to set up a proper stereo configuration
         bool busesConfigured = false;
-        int numInputBuses = loadedPlugin->getBusCount(true);
-        int numOutputBuses = loadedPlugin->getBusCount(false);
-        
-        DBG("Plugin has " + juce::String(numInputBuses) + " input bus(es) and " + 
+        int numInputBuses = plugin.getBusCount(true);
+        int numOutputBuses = plugin.getBusCount(false);
+
+        DBG("Plugin has " + juce::String(numInputBuses) + " input bus(es) and " +
             juce::String(numOutputBuses) + " output bus(es)");
-        
+
         if (numInputBuses > 0 && numOutputBuses > 0)
         {
             // Try to enable stereo input/output
             juce::AudioProcessor::BusesLayout layout;
             layout.inputBuses.add(juce::AudioChannelSet::stereo());
             layout.outputBuses.add(juce::AudioChannelSet::stereo());
-            
-            if (loadedPlugin->setBusesLayout(layout))
+
+            if (plugin.setBusesLayout(layout))
             {
                 DBG("Successfully configured stereo I/O layout");
                 busesConfigured = true;
@@ -215,8 +1067,8 @@ private:
                 layout.outputBuses.clear();
                 layout.inputBuses.add(juce::AudioChannelSet::mono());
                 layout.outputBuses.add(juce::AudioChannelSet::mono());
-                
-                if (loadedPlugin->setBusesLayout(layout))
+
+                if (plugin.setBusesLayout(layout))
                 {
                     DBG("Successfully configured mono I/O layout");
                     busesConfigured = true;
@@ -228,99 +1080,273 @@ private:
             // Output-only plugin (e.g., synth)
             juce::AudioProcessor::BusesLayout layout;
             layout.outputBuses.add(juce::AudioChannelSet::stereo());
-            
-            if (loadedPlugin->setBusesLayout(layout))
+
+            if (plugin.setBusesLayout(layout))
             {
                 DBG("Successfully configured stereo output layout");
                 busesConfigured = true;
             }
         }
-        
+
         if (!busesConfigured)
         {
             DBG("Using default bus configuration from enableAllBuses()");
         }
-        
-        audioEngine.setProcessor(loadedPlugin.get());
+    }
+
+    // Further instances come from the first one's description, which skips the search
+    std::unique_ptr<juce::AudioPluginInstance> loadAnotherInstance(const juce::String& name)
+    {
+        if (auto instance = pluginLoader.loadPluginFromDescription(loadedPlugin->getPluginDescription()))
+            return instance;
+
+        return pluginLoader.loadPlugin(name);
+    }
+
+    // Multi-mono: one instance per channel (or channel pair), all following the first one
+    // Returns false, with nothing handed to the engine, if an instance rejects the layout
+    bool loadMultiMonoCopies(const juce::String& name)
+    {
+        const int channelsPerCopy = options.multiMonoChannels;
+        const int numCopies = juce::jmax(1, (audioEngine.getNumActiveChannels() + channelsPerCopy - 1) / channelsPerCopy);
+
+        if (!configureMultiMonoBuses(*loadedPlugin, channelsPerCopy))
+            return false;
+
+        juce::MemoryBlock state;
+        loadedPlugin->getStateInformation(state);
 
-        if (loadedPlugin->hasEditor())
+        juce::Array<juce::AudioProcessor*> copies { loadedPlugin.get() };
+        juce::Array<juce::AudioProcessor*> followers;
+
+        for (int i = 1; i < numCopies; ++i)
         {
-            DBG("Plugin reports having an editor. Creating...");
-            juce::AudioProcessorEditor* editor = loadedPlugin->createEditor();
+            auto copy = loadAnotherInstance(name);
+            if (!copy)
+            {
+                PluginLoader::LOG("Multi-mono: could not load instance " + juce::String(i + 1) + ": " + pluginLoader.getLastError());
+                break;
+            }
 
-            if (editor != nullptr)
+            if (!configureMultiMonoBuses(*copy, channelsPerCopy))
             {
-                DBG("Editor created successfully.");
-                pluginEditor.reset(editor); // Take ownership
+                multiMonoCopies.clear();
+                return false;
+            }
 
-                addAndMakeVisible(pluginEditor.get());
+            if (state.getSize() > 0)
+                copy->setStateInformation(state.getData(), (int) state.getSize());
 
-                int width = pluginEditor->getWidth();
-                int height = pluginEditor->getHeight();
-                DBG("Editor initial size reported: " + juce::String(width) + "x" + juce::String(height));
+            copies.add(copy.get());
+            followers.add(copy.get());
+            multiMonoCopies.add(copy.release());
+        }
 
-                const int defaultWidth = 600;
-                const int defaultHeight = 400;
-                if (width <= 0) width = defaultWidth;
-                if (height <= 0) height = defaultHeight;
+        audioEngine.setMultiMonoProcessors(copies, channelsPerCopy);
+        parameterLink = std::make_unique<ParameterLink>(*loadedPlugin, followers);
 
-                // Set *this* component's size FIRST. This triggers MainComponent::resized(),
-                // which sets editor bounds AND calls updateParentWindowSize().
-                setSize(width, height);
-                DBG("MainComponent initial size set to: " + juce::String(width) + "x" + juce::String(height));
+        PluginLoader::LOG("Multi-mono: " + juce::String(copies.size()) + " instance(s) x "
+                          + juce::String(channelsPerCopy) + " channel(s), "
+                          + juce::String(audioEngine.getNumWorkerThreads()) + " worker thread(s)");
+        return true;
+    }
 
-                // ** NOW add the listener for future changes **
-                pluginEditor->addComponentListener(this);
-                DBG("Added ComponentListener to plugin editor.");
+    // The engine hands each copy exactly channelsPerCopy channels, so any other
+    // layout the plugin might settle on is a failure
+    bool configureMultiMonoBuses(juce::AudioPluginInstance& plugin, int channelsPerCopy)
+    {
+        TRACE_SCOPE("configureMultiMonoBuses");
+        plugin.enableAllBuses();
 
-                status = LoadStatus::LoadedWithEditor;
-                audioEngine.start();
+        const auto channelSet = channelsPerCopy == 1 ? juce::AudioChannelSet::mono() : juce::AudioChannelSet::stereo();
+        juce::AudioProcessor::BusesLayout layout;
+        if (plugin.getBusCount(true) > 0)
+            layout.inputBuses.add(channelSet);
+        layout.outputBuses.add(channelSet);
 
-                // Set initial window resizability based on editor
-                if (auto* dw = findParentComponentOfClass<juce::DocumentWindow>())
-                {
-                    bool canResize = true;
-                    if (pluginEditor->getConstrainer() != nullptr) {
-                        canResize = (pluginEditor->getConstrainer()->getMinimumWidth() != pluginEditor->getConstrainer()->getMaximumWidth()) ||
-                                    (pluginEditor->getConstrainer()->getMinimumHeight() != pluginEditor->getConstrainer()->getMaximumHeight());
-                    } else if (!pluginEditor->isResizable()) {
-                        canResize = false;
-                    }
-                    dw->setResizable(canResize, canResize);
-
-                    if (auto* constrainer = pluginEditor->getConstrainer())
-                        dw->setResizeLimits(constrainer->getMinimumWidth(), constrainer->getMinimumHeight(),
-                                         constrainer->getMaximumWidth(), constrainer->getMaximumHeight());
-                    else if (!canResize)
-                        dw->setResizeLimits(width, height, width, height);
-                }
+        if (!plugin.setBusesLayout(layout))
+        {
+            PluginLoader::LOG("Multi-mono: plugin rejected the " + channelSet.getDescription()
+                              + " layout, running a single instance instead");
+            return false;
+        }
 
-                DBG("Plugin loading complete with editor.");
-                return; // Success
-            }
-            else
+        return true;
+    }
+
+    // A/B comparison: a second instance of the same plugin, starting from A's state
+    void loadComparisonInstance(const juce::String& name)
+    {
+        comparisonPlugin = loadAnotherInstance(name);
+
+        if (!comparisonPlugin)
+        {
+            DBG("A/B: could not load second instance: " + pluginLoader.getLastError());
+            return;
+        }
+
+        configureBuses(*comparisonPlugin);
+
+        juce::MemoryBlock state;
+        loadedPlugin->getStateInformation(state);
+        if (state.getSize() > 0)
+            comparisonPlugin->setStateInformation(state.getData(), (int) state.getSize());
+
+        audioEngine.setSlotProcessor(1, comparisonPlugin.get());
+        DBG("A/B: second instance ready. Press A, B or Tab to switch.");
+
+        startTimerHz(4); // Load display in the title bar
+    }
+
+    // Switches audio to the given slot and shows that instance's editor
+    void switchToSlot(int slot)
+    {
+        auto* plugin = getSlotPlugin(slot);
+        if (plugin == nullptr || slot == audioEngine.getActiveSlot())
+            return;
+
+        audioEngine.selectSlot(slot);
+        publishParameterRegistry(slot);
+
+        destroyEditor();
+        if (!showEditorFor(*plugin))
+        {
+            status = LoadStatus::LoadedNoEditor;
+            setSize(600, 360);
+        }
+
+        updateAnalyzer();
+        menuItemsChanged();
+
+        timerCallback();
+    }
+
+    void timerCallback() override
+    {
+        if (auto* dw = findParentComponentOfClass<juce::DocumentWindow>())
+        {
+            auto percent = [](double load) { return juce::String(juce::roundToInt(load * 100.0)) + "%"; };
+
+            if (!hotListPlugins.isEmpty())
             {
-                DBG("Plugin reported hasEditor() but createEditor() returned nullptr.");
-                // Fall through to LoadedNoEditor status
+                const int slot = audioEngine.getActiveSlot();
+                dw->setName(juce::JUCEApplication::getInstance()->getApplicationName()
+                            + "  [" + juce::String(slot + 1) + "/" + juce::String(hotListPlugins.size() + 1)
+                            + " " + getSlotPlugin(slot)->getName() + "]"
+                            + "  DSP " + percent(audioEngine.getCpuLoad()));
+                return;
             }
+
+            dw->setName(juce::JUCEApplication::getInstance()->getApplicationName()
+                        + (audioEngine.getActiveSlot() == 0 ? "  [A]" : "  [B]")
+                        + "  DSP " + percent(audioEngine.getCpuLoad())
+                        + " (A " + percent(audioEngine.getSlotLoad(0))
+                        + " / B " + percent(audioEngine.getSlotLoad(1)) + ")");
         }
-        else
+    }
+
+    // Creates the plugin's editor and sizes this component (and the window) to it.
+    // Returns false if the plugin has no editor.
+    bool showEditorFor(juce::AudioPluginInstance& plugin)
+    {
+        if (!plugin.hasEditor())
         {
             DBG("Plugin does not have an editor interface.");
+            return false;
         }
 
-        // --- Plugin loaded, but no editor ---
-        status = LoadStatus::LoadedNoEditor;
-        setSize(400, 200); // Ensure default size for message
-        audioEngine.start(); // Start audio processing anyway
-        DBG("Plugin loading complete without editor.");
-        // No listener needed if there's no editor
+        DBG("Plugin reports having an editor. Creating...");
+        Tracer::Span editorSpan("createEditor");
+        juce::AudioProcessorEditor* editor = plugin.createEditor();
+        editorSpan.end();
+
+        if (editor == nullptr)
+        {
+            DBG("Plugin reported hasEditor() but createEditor() returned nullptr.");
+            return false;
+        }
+
+        DBG("Editor created successfully.");
+        pluginEditor.reset(editor); // Take ownership
+
+        addAndMakeVisible(pluginEditor.get());
+
+        int width = pluginEditor->getWidth();
+        int height = pluginEditor->getHeight();
+        DBG("Editor initial size reported: " + juce::String(width) + "x" + juce::String(height));
+
+        const int defaultWidth = 600;
+        const int defaultHeight = 400;
+        if (width <= 0) width = defaultWidth;
+        if (height <= 0) height = defaultHeight;
+
+        // Set *this* component's size FIRST. This triggers MainComponent::resized(),
+        // which sets editor bounds AND calls updateParentWindowSize().
+        setSize(width, height);
+        DBG("MainComponent initial size set to: " + juce::String(width) + "x" + juce::String(height));
+
+        // ** NOW add the listener for future changes **
+        pluginEditor->addComponentListener(this);
+        DBG("Added ComponentListener to plugin editor.");
+
+        status = LoadStatus::LoadedWithEditor;
+
+        // Set initial window resizability based on editor
+        if (auto* dw = findParentComponentOfClass<juce::DocumentWindow>())
+        {
+            bool canResize = true;
+            if (pluginEditor->getConstrainer() != nullptr) {
+                canResize = (pluginEditor->getConstrainer()->getMinimumWidth() != pluginEditor->getConstrainer()->getMaximumWidth()) ||
+                            (pluginEditor->getConstrainer()->getMinimumHeight() != pluginEditor->getConstrainer()->getMaximumHeight());
+            } else if (!pluginEditor->isResizable()) {
+                canResize = false;
+            }
+            dw->setResizable(canResize, canResize);
+
+            if (auto* constrainer = pluginEditor->getConstrainer())
+                dw->setResizeLimits(constrainer->getMinimumWidth(), constrainer->getMinimumHeight(),
+                                 constrainer->getMaximumWidth(), constrainer->getMaximumHeight());
+            else if (!canResize)
+                dw->setResizeLimits(width, height, width, height);
+        }
+
+        return true;
     }
 
+    void destroyEditor()
+    {
+        // Remove listener *before* destroying the editor
+        if (pluginEditor != nullptr)
+        {
+            pluginEditor->removeComponentListener(this);
+            DBG("Removed ComponentListener from plugin editor.");
+        }
+
+        pluginEditor = nullptr;
+    }
+
+    HostOptions options;
     PluginLoader pluginLoader;
     AudioEngine audioEngine;
     std::unique_ptr<juce::AudioPluginInstance> loadedPlugin;
+    std::unique_ptr<juce::AudioPluginInstance> comparisonPlugin; // B instance in A/B mode
     std::unique_ptr<juce::AudioProcessorEditor> pluginEditor;
+    std::unique_ptr<OscControlServer> oscServer;
+    std::unique_ptr<BufferSizeProber> bufferSizeProber;
+    std::unique_ptr<RenderDaemon> renderDaemon;
+    juce::OwnedArray<juce::AudioPluginInstance> daemonInstances; // Workers 2..N in daemon mode
+    std::unique_ptr<AnalyzerComponent> analyzer;
+    bool analyzerIsOverlay{false};
+    bool showAnalyzerOverlay{false};
+    static constexpr int analyzerMessageHeight = 30;
+    juce::OwnedArray<juce::AudioPluginInstance> multiMonoCopies; // Copies 2..N in multi-mono mode
+    juce::OwnedArray<juce::AudioPluginInstance> hotListPlugins; // Slots 1..N with --hotlist
+    int hotListLoadIndex{0};
+    std::unique_ptr<ParameterLink> parameterLink;
+    std::array<std::unique_ptr<ParameterRegistry>, AudioEngine::maxSlots> parameterRegistries; // One per slot, built on first use
+    std::unique_ptr<SessionSnapshot> warmStart; // Only set while the plugin is being loaded
+    std::unique_ptr<StateAutosaver> autosaver; // Crash recovery for loadedPlugin's state
+    juce::File loadedBundle;
 
     // State Members
     LoadStatus status { LoadStatus::NoPlugin };
@@ -342,21 +1368,38 @@ public:
 
     const juce::String getApplicationVersion() override { return "1.0.3"; } // Version bump
 
-    void initialise(const juce::String& /*commandLine*/) override
+    void initialise(const juce::String& commandLine) override
     {
-        mainWindow.reset(new MainWindow(getApplicationName()));
+        options = HostOptions::fromCommandLine(commandLine);
+
+        if (options.audit)
+        {
+            RealtimeAuditor::enable();
+            RealtimeAuditor::setWaitFailThreshold(options.auditWaitFailMs / 1000.0);
+        }
+
+        if (options.trace)
+            Tracer::enable();
+
+        mainWindow.reset(new MainWindow(getApplicationName(), options));
     }
 
     void shutdown() override
     {
         mainWindow = nullptr;
+
+        if (options.audit)
+            writeAuditReport();
+
+        if (options.trace)
+            writeTrace(getTraceFile(options));
     }
 
     // --- MainWindow nested class ---
     class MainWindow : public juce::DocumentWindow
     {
     public:
-        MainWindow(juce::String name)
+        MainWindow(juce::String name, const HostOptions& options)
             : DocumentWindow(name,
                              juce::Desktop::getInstance().getDefaultLookAndFeel()
                                  .findColour(juce::ResizableWindow::backgroundColourId),
@@ -368,7 +1411,7 @@ public:
             setResizable(true, true);
 
             // 1. Create the MainComponent
-            auto mainComp = std::make_unique<MainComponent>();
+            auto mainComp = std::make_unique<MainComponent>(options);
 
             // 2. Get its final initial size
             int contentWidth = mainComp->getWidth();
@@ -400,6 +1443,26 @@ public:
     // --- End MainWindow nested class ---
 
 private:
+    // Audit mode: the report goes to the log (and a file if one was given),
+    // and the exit code tells a CI job whether the plugin passed
+    void writeAuditReport()
+    {
+        auto report = RealtimeAuditor::createReport();
+        PluginLoader::LOG(report);
+
+        if (options.auditReportPath.isNotEmpty())
+        {
+            juce::File reportFile(juce::File::getCurrentWorkingDirectory().getChildFile(options.auditReportPath));
+            if (!reportFile.replaceWithText(report))
+                PluginLoader::LOG("Could not write audit report: " + reportFile.getFullPathName());
+        }
+
+        // An incomplete audit can't vouch for the plugin either
+        if (RealtimeAuditor::hasViolations() || !RealtimeAuditor::isComplete())
+            setApplicationReturnValue(1);
+    }
+
+    HostOptions options;
     std::unique_ptr<MainWindow> mainWindow;
 };
 
@@ -0,0 +1,26 @@
+#include "ParameterLink.h"
+
+ParameterLink::ParameterLink(juce::AudioProcessor& leaderProcessor, const juce::Array<juce::AudioProcessor*>& followerProcessors)
+    : leader(leaderProcessor), followers(followerProcessors)
+{
+    for (auto* parameter : leader.getParameters())
+        parameter->addListener(this);
+}
+
+ParameterLink::~ParameterLink()
+{
+    for (auto* parameter : leader.getParameters())
+        parameter->removeListener(this);
+}
+
+void ParameterLink::parameterValueChanged(int parameterIndex, float newValue)
+{
+    for (auto* follower : followers)
+    {
+        const auto& parameters = follower->getParameters();
+
+        // setValue() doesn't notify listeners, so this can't feed back
+        if (juce::isPositiveAndBelow(parameterIndex, parameters.size()))
+            parameters[parameterIndex]->setValue(newValue);
+    }
+}
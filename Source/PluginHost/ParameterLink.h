@@ -0,0 +1,22 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Keeps a set of plugin instances in step with a leader instance by copying
+// every parameter change made on the leader (from its editor, automation or
+// the host) onto the same parameter index of each follower.
+class ParameterLink : private juce::AudioProcessorParameter::Listener
+{
+public:
+    ParameterLink(juce::AudioProcessor& leaderProcessor, const juce::Array<juce::AudioProcessor*>& followerProcessors);
+    ~ParameterLink() override;
+
+private:
+    // May be called on any thread, including the audio thread
+    void parameterValueChanged(int parameterIndex, float newValue) override;
+    void parameterGestureChanged(int, bool) override {}
+
+    juce::AudioProcessor& leader;
+    juce::Array<juce::AudioProcessor*> followers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParameterLink)
+};
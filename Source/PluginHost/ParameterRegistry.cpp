@@ -0,0 +1,111 @@
+#include "ParameterRegistry.h"
+
+ParameterRegistry::ParameterRegistry(juce::AudioProcessor& p)
+    : processor(p)
+{
+    const auto& processorParameters = processor.getParameters();
+    const int numParameters = processorParameters.size();
+
+    parameters.assign(processorParameters.begin(), processorParameters.end());
+    values = std::vector<std::atomic<float>>((size_t) numParameters);
+    dirtyWords = std::vector<std::atomic<juce::uint64>>((size_t) (numParameters + 63) / 64);
+    changedIndices.ensureStorageAllocated(numParameters);
+
+    idToIndex.remapTable(numParameters * 2);
+    nameToIndex.remapTable(numParameters * 2);
+
+    for (int i = 0; i < numParameters; ++i)
+    {
+        auto* parameter = parameters[(size_t) i];
+
+        // Hosted plugins (AU/VST3) provide a stable ID; anything else falls back to the index
+        juce::String parameterID;
+        if (auto* hosted = dynamic_cast<juce::HostedAudioProcessorParameter*>(parameter))
+            parameterID = hosted->getParameterID();
+        else if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*>(parameter))
+            parameterID = withID->paramID;
+
+        if (parameterID.isEmpty())
+            parameterID = juce::String(i);
+
+        parameterIDs.add(parameterID);
+        idToIndex.set(parameterID, i);
+
+        // First one wins if several parameters share a name
+        const auto name = parameter->getName(1024);
+        if (!nameToIndex.contains(name))
+            nameToIndex.set(name, i);
+
+        values[(size_t) i].store(parameter->getValue());
+        parameter->addListener(this);
+    }
+
+    DBG("Parameter registry: " + juce::String(numParameters) + " parameters");
+    startTimerHz(notificationRateHz);
+}
+
+ParameterRegistry::~ParameterRegistry()
+{
+    stopTimer();
+
+    for (auto* parameter : parameters)
+        parameter->removeListener(this);
+}
+
+int ParameterRegistry::indexOfID(const juce::String& parameterID) const
+{
+    return idToIndex.contains(parameterID) ? idToIndex[parameterID] : -1;
+}
+
+int ParameterRegistry::indexOfName(const juce::String& name) const
+{
+    return nameToIndex.contains(name) ? nameToIndex[name] : -1;
+}
+
+juce::AudioProcessorParameter* ParameterRegistry::getParameter(int index) const
+{
+    return juce::isPositiveAndBelow(index, size()) ? parameters[(size_t) index] : nullptr;
+}
+
+juce::String ParameterRegistry::getParameterID(int index) const
+{
+    return parameterIDs[index];
+}
+
+float ParameterRegistry::getValue(int index) const
+{
+    return juce::isPositiveAndBelow(index, size()) ? values[(size_t) index].load(std::memory_order_relaxed) : 0.0f;
+}
+
+void ParameterRegistry::parameterValueChanged(int parameterIndex, float newValue)
+{
+    if (!juce::isPositiveAndBelow(parameterIndex, size()))
+        return;
+
+    values[(size_t) parameterIndex].store(newValue, std::memory_order_relaxed);
+    dirtyWords[(size_t) (parameterIndex / 64)].fetch_or((juce::uint64) 1 << (parameterIndex % 64), std::memory_order_release);
+    anyDirty.store(true, std::memory_order_release);
+}
+
+void ParameterRegistry::timerCallback()
+{
+    if (!anyDirty.exchange(false, std::memory_order_acquire))
+        return;
+
+    changedIndices.clearQuick();
+
+    for (size_t word = 0; word < dirtyWords.size(); ++word)
+    {
+        auto bits = dirtyWords[word].exchange(0, std::memory_order_acquire);
+
+        while (bits != 0)
+        {
+            const int bit = juce::countNumberOfBits((juce::uint64) ((bits & (~bits + 1)) - 1));
+            changedIndices.add((int) word * 64 + bit);
+            bits &= bits - 1;
+        }
+    }
+
+    if (!changedIndices.isEmpty())
+        listeners.call([this](Listener& l) { l.parametersChanged(*this, changedIndices); });
+}
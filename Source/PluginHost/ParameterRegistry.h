@@ -0,0 +1,83 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <vector>
+
+// Host-side index of a plugin's parameters, built once after the plugin is
+// loaded, for plugins with thousands of parameters.
+//
+// - Parameter IDs and names resolve to a dense index through hash maps
+//   instead of a linear search of getParameters().
+// - The latest normalised value of every parameter is kept in a flat array.
+// - Changes from any thread (including the audio thread) only set a bit in
+//   a dirty bitset. Once per UI frame the message thread collects the bits
+//   and calls each listener once with every index that changed, so a preset
+//   change touching 3000 parameters is one notification, not 3000.
+//
+// The maps and the parameter list never change after construction, so
+// lookups are safe from any thread.
+//
+// The OSC server is the only listener for now; the host has no parameter UI
+// of its own, the plugin's editor draws its own. Main builds one registry per
+// engine slot (the loaded plugin, the B instance or each hot-list plugin) and
+// publishes the audible one. Multi-mono copies aren't indexed: they are kept
+// in step with the first instance, which is.
+class ParameterRegistry : private juce::AudioProcessorParameter::Listener,
+                          private juce::Timer
+{
+public:
+    static constexpr int notificationRateHz = 30;
+
+    explicit ParameterRegistry(juce::AudioProcessor& processor);
+    ~ParameterRegistry() override;
+
+    int size() const { return (int) parameters.size(); }
+
+    // The plugin the indices belong to
+    juce::AudioProcessor& getProcessor() const { return processor; }
+
+    // Dense index for a parameter ID or name, or -1
+    int indexOfID(const juce::String& parameterID) const;
+    int indexOfName(const juce::String& name) const;
+
+    juce::AudioProcessorParameter* getParameter(int index) const;
+    juce::String getParameterID(int index) const;
+
+    // Latest normalised value seen, from the flat snapshot
+    float getValue(int index) const;
+
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+
+        // Message thread, at most once per frame. changedIndices is only valid during the call.
+        virtual void parametersChanged(const ParameterRegistry& registry, const juce::Array<int>& changedIndices) = 0;
+    };
+
+    void addListener(Listener* listener) { listeners.add(listener); }
+    void removeListener(Listener* listener) { listeners.remove(listener); }
+
+private:
+    // Any thread: records the value and marks the parameter dirty
+    void parameterValueChanged(int parameterIndex, float newValue) override;
+    void parameterGestureChanged(int, bool) override {}
+
+    // Message thread: drains the dirty bits and notifies listeners
+    void timerCallback() override;
+
+    juce::AudioProcessor& processor;
+    std::vector<juce::AudioProcessorParameter*> parameters;
+    juce::StringArray parameterIDs;
+    juce::HashMap<juce::String, int> idToIndex;
+    juce::HashMap<juce::String, int> nameToIndex;
+
+    std::vector<std::atomic<float>> values;
+    std::vector<std::atomic<juce::uint64>> dirtyWords;
+    std::atomic<bool> anyDirty{false};
+
+    juce::Array<int> changedIndices; // Reused for every notification
+    juce::ListenerList<Listener> listeners;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParameterRegistry)
+};
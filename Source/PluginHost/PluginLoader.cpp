@@ -1,4 +1,5 @@
 #include "PluginLoader.h"
+#include "../Diagnostics/Tracer.h"
 
 #if JUCE_MAC
 #include <AudioUnit/AudioUnit.h>
@@ -30,6 +31,13 @@ juce::File PluginLoader::getLogFile()
     return logFile;
 }
 
+juce::File PluginLoader::getDataDirectory()
+{
+    auto directory = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getChildFile("TowelHost");
+    directory.createDirectory();
+    return directory;
+}
+
 // Log to both console and file
 void PluginLoader::LOG(const juce::String& message)
 {
@@ -52,7 +60,9 @@ PluginLoader::~PluginLoader()
 
 std::unique_ptr<juce::AudioPluginInstance> PluginLoader::loadPlugin(const juce::String& filePath)
 {
+    TRACE_SCOPE("PluginLoader::loadPlugin");
     lastErrorMessage = ""; // Clear previous error
+    lastResolvedFile = juce::File();
     
     if (filePath.isEmpty())
     {
@@ -88,6 +98,7 @@ std::unique_ptr<juce::AudioPluginInstance> PluginLoader::loadPlugin(const juce::
     auto appDirectory = appBundle.getParentDirectory();
     
     auto file = juce::File(filePath);
+    Tracer::Span searchSpan("Plugin path search");
     
     LOG("=== SAVIHOST-style Plugin Search ===");
     LOG("Executable: " + appFile.getFullPathName());
@@ -166,6 +177,8 @@ std::unique_ptr<juce::AudioPluginInstance> PluginLoader::loadPlugin(const juce::
         }
     }
 
+    searchSpan.end();
+
     if (!file.exists())
     {
         lastErrorMessage = "Component file not found: " + filePath + ".component\n\n" +
@@ -181,6 +194,7 @@ std::unique_ptr<juce::AudioPluginInstance> PluginLoader::loadPlugin(const juce::
     
     LOG("\n=== Using Component ===");
     LOG("Path: " + file.getFullPathName());
+    lastResolvedFile = file;
 
     // Check if it's actually a bundle (component files are bundles/directories)
     if (!file.isDirectory())
@@ -209,7 +223,10 @@ std::unique_ptr<juce::AudioPluginInstance> PluginLoader::loadPlugin(const juce::
     
     // Direct scan of the specific component file
     LOG("Scanning specific component file...");
-    auFormat->findAllTypesForFile(descriptions, file.getFullPathName());
+    {
+        TRACE_SCOPE("Component scan");
+        auFormat->findAllTypesForFile(descriptions, file.getFullPathName());
+    }
     LOG("Found " + juce::String(descriptions.size()) + " description(s)");
     
     // If JUCE can't find it, try direct instantiation with a minimal description
@@ -231,7 +248,9 @@ std::unique_ptr<juce::AudioPluginInstance> PluginLoader::loadPlugin(const juce::
         
         // Try to instantiate directly - this will force JUCE/macOS to load and validate it
         LOG("Trying to instantiate with path-only description...");
+        Tracer::Span directSpan("Instantiate (path-only description)");
         auto directInstance = auFormat->createInstanceFromDescription(*pluginDesc, 44100.0, 512, errorMessage);
+        directSpan.end();
         
         if (directInstance)
         {
@@ -246,7 +265,9 @@ std::unique_ptr<juce::AudioPluginInstance> PluginLoader::loadPlugin(const juce::
             pluginDesc->isInstrument = true;
             pluginDesc->numInputChannels = 0;
             LOG("Trying as instrument...");
+            Tracer::Span instrumentSpan("Instantiate (path-only, as instrument)");
             directInstance = auFormat->createInstanceFromDescription(*pluginDesc, 44100.0, 512, errorMessage);
+            instrumentSpan.end();
             
             if (directInstance)
             {
@@ -322,7 +343,9 @@ std::unique_ptr<juce::AudioPluginInstance> PluginLoader::loadPlugin(const juce::
         LOG("Attempting to instantiate [" + juce::String(i) + "]: " + desc->name);
         errorMessage.clear();
         
+        Tracer::Span attemptSpan("Instantiate description", i);
         instance = auFormat->createInstanceFromDescription(*desc, sampleRate, blockSize, errorMessage);
+        attemptSpan.end();
         
         if (instance)
         {
@@ -348,6 +371,28 @@ std::unique_ptr<juce::AudioPluginInstance> PluginLoader::loadPlugin(const juce::
     return nullptr;
 }
 
+std::unique_ptr<juce::AudioPluginInstance> PluginLoader::loadPluginFromDescription(const juce::PluginDescription& description)
+{
+    TRACE_SCOPE("PluginLoader::loadPluginFromDescription");
+    lastErrorMessage = "";
+
+    LOG("Loading plugin from saved description: " + description.name +
+        " (ID: " + description.createIdentifierString() + ")");
+
+    juce::String errorMessage;
+    auto instance = formatManager->createPluginInstance(description, 44100.0, 512, errorMessage);
+
+    if (!instance)
+    {
+        lastErrorMessage = "Failed to create plugin from saved description: " + errorMessage;
+        LOG(lastErrorMessage);
+        return nullptr;
+    }
+
+    LOG("✓ Successfully created plugin instance: " + instance->getName());
+    return instance;
+}
+
 juce::Array<juce::File> PluginLoader::getAudioUnitSearchPaths(const juce::String& componentName)
 {
     juce::Array<juce::File> paths;
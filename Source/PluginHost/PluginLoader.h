@@ -8,15 +8,27 @@ public:
     ~PluginLoader();
     
     std::unique_ptr<juce::AudioPluginInstance> loadPlugin(const juce::String& filePath);
+
+    // Instantiates straight from a description saved earlier, skipping the search and scan
+    std::unique_ptr<juce::AudioPluginInstance> loadPluginFromDescription(const juce::PluginDescription& description);
+
     static juce::String getExecutableName();
     juce::String getLastError() const { return lastErrorMessage; }
+
+    // Component bundle the last successful loadPlugin() call resolved to
+    juce::File getLastResolvedFile() const { return lastResolvedFile; }
+
     static juce::File getLogFile();
+
+    // Per-user folder for session snapshots and other persisted data
+    static juce::File getDataDirectory();
     static void LOG(const juce::String& message);
     
 private:
     std::unique_ptr<juce::AudioPluginFormatManager> formatManager;
     juce::Array<juce::File> getAudioUnitSearchPaths(const juce::String& componentName);
     juce::String lastErrorMessage;
+    juce::File lastResolvedFile;
     static juce::File logFile;
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PluginLoader)
 };
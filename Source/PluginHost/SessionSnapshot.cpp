@@ -0,0 +1,146 @@
+#include "SessionSnapshot.h"
+#include "PluginLoader.h"
+
+namespace
+{
+    const juce::Identifier sessionId("TowelHostSession");
+    const juce::Identifier versionId("version");
+    const juce::Identifier pluginNameId("pluginName");
+    const juce::Identifier bundleId("bundle");
+    const juce::Identifier bundleTimeId("bundleTime");
+    const juce::Identifier bundleFingerprintId("bundleFingerprint");
+    const juce::Identifier descriptionId("description");
+    const juce::Identifier inputBusesId("inputBuses");
+    const juce::Identifier outputBusesId("outputBuses");
+    const juce::Identifier deviceStateId("deviceState");
+    const juce::Identifier pluginStateId("pluginState");
+    const juce::Identifier windowWidthId("windowWidth");
+    const juce::Identifier windowHeightId("windowHeight");
+
+    constexpr int currentVersion = 2;
+}
+
+juce::File SessionSnapshot::getFileFor(const juce::String& pluginName)
+{
+    return PluginLoader::getDataDirectory().getChildFile(juce::File::createLegalFileName(pluginName) + ".session");
+}
+
+juce::String SessionSnapshot::getBundleFingerprint(const juce::File& bundleToCheck)
+{
+    const auto contents = bundleToCheck.getChildFile("Contents");
+    auto files = contents.getChildFile("MacOS").findChildFiles(juce::File::findFiles, false);
+    files.sort();
+    files.insert(0, contents.getChildFile("Info.plist"));
+
+    juce::StringArray entries;
+    for (const auto& file : files)
+        entries.add(file.getRelativePathFrom(bundleToCheck) + ":" + juce::String(file.getSize()) + ":"
+                    + juce::String(file.getLastModificationTime().toMilliseconds()));
+
+    return entries.joinIntoString("|");
+}
+
+void SessionSnapshot::setBundle(const juce::File& newBundle)
+{
+    bundle = newBundle;
+    bundleModificationTime = newBundle.getLastModificationTime();
+    bundleFingerprint = getBundleFingerprint(newBundle);
+}
+
+bool SessionSnapshot::isValidFor(const juce::String& name) const
+{
+    return pluginName == name
+        && bundle.isDirectory()
+        && bundle.getLastModificationTime() == bundleModificationTime
+        && getBundleFingerprint(bundle) == bundleFingerprint;
+}
+
+void SessionSnapshot::setBusesLayout(const juce::AudioProcessor::BusesLayout& layout)
+{
+    inputBuses.clear();
+    outputBuses.clear();
+
+    for (const auto& bus : layout.inputBuses)
+        inputBuses.add(bus.getSpeakerArrangementAsString());
+    for (const auto& bus : layout.outputBuses)
+        outputBuses.add(bus.getSpeakerArrangementAsString());
+}
+
+juce::AudioProcessor::BusesLayout SessionSnapshot::getBusesLayout() const
+{
+    juce::AudioProcessor::BusesLayout layout;
+
+    for (const auto& bus : inputBuses)
+        layout.inputBuses.add(juce::AudioChannelSet::fromAbbreviatedString(bus));
+    for (const auto& bus : outputBuses)
+        layout.outputBuses.add(juce::AudioChannelSet::fromAbbreviatedString(bus));
+
+    return layout;
+}
+
+bool SessionSnapshot::save(const juce::File& file) const
+{
+    juce::ValueTree tree(sessionId);
+    tree.setProperty(versionId, currentVersion, nullptr);
+    tree.setProperty(pluginNameId, pluginName, nullptr);
+    tree.setProperty(bundleId, bundle.getFullPathName(), nullptr);
+    tree.setProperty(bundleTimeId, bundleModificationTime.toMilliseconds(), nullptr);
+    tree.setProperty(bundleFingerprintId, bundleFingerprint, nullptr);
+    tree.setProperty(inputBusesId, inputBuses.joinIntoString("|"), nullptr);
+    tree.setProperty(outputBusesId, outputBuses.joinIntoString("|"), nullptr);
+    tree.setProperty(pluginStateId, pluginState, nullptr);
+    tree.setProperty(windowWidthId, windowWidth, nullptr);
+    tree.setProperty(windowHeightId, windowHeight, nullptr);
+
+    if (auto xml = description.createXml())
+        tree.setProperty(descriptionId, xml->toString(juce::XmlElement::TextFormat().singleLine()), nullptr);
+
+    if (deviceState != nullptr)
+        tree.setProperty(deviceStateId, deviceState->toString(juce::XmlElement::TextFormat().singleLine()), nullptr);
+
+    // Write next to the target and rename, so a crash never leaves half a snapshot
+    juce::TemporaryFile temp(file);
+    {
+        juce::FileOutputStream out(temp.getFile());
+        if (!out.openedOk())
+            return false;
+
+        tree.writeToStream(out);
+    }
+
+    return temp.overwriteTargetFileWithTemporary();
+}
+
+bool SessionSnapshot::load(const juce::File& file)
+{
+    if (!file.existsAsFile())
+        return false;
+
+    juce::MemoryMappedFile mapped(file, juce::MemoryMappedFile::readOnly);
+    if (mapped.getData() == nullptr)
+        return false;
+
+    auto tree = juce::ValueTree::readFromData(mapped.getData(), mapped.getSize());
+    if (!tree.hasType(sessionId) || (int) tree.getProperty(versionId) != currentVersion)
+        return false;
+
+    auto descriptionXml = juce::parseXML(tree.getProperty(descriptionId).toString());
+    if (descriptionXml == nullptr || !description.loadFromXml(*descriptionXml))
+        return false;
+
+    pluginName = tree.getProperty(pluginNameId).toString();
+    bundle = juce::File(tree.getProperty(bundleId).toString());
+    bundleModificationTime = juce::Time((juce::int64) tree.getProperty(bundleTimeId));
+    bundleFingerprint = tree.getProperty(bundleFingerprintId).toString();
+    inputBuses = juce::StringArray::fromTokens(tree.getProperty(inputBusesId).toString(), "|", {});
+    outputBuses = juce::StringArray::fromTokens(tree.getProperty(outputBusesId).toString(), "|", {});
+    deviceState = juce::parseXML(tree.getProperty(deviceStateId).toString());
+    windowWidth = tree.getProperty(windowWidthId);
+    windowHeight = tree.getProperty(windowHeightId);
+
+    pluginState.reset();
+    if (auto* state = tree.getProperty(pluginStateId).getBinaryData())
+        pluginState = *state;
+
+    return true;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Everything needed to bring a renamed TowelHost back to where it was
+// without redoing discovery: the resolved component bundle, the plugin
+// description that instantiated, the negotiated bus layout, the audio
+// device setup, the plugin state and the window size.
+//
+// Written on quit and read on the next launch with a single memory-mapped
+// read. isValidFor() decides whether the saved discovery results still
+// apply; if not, the normal cold start runs.
+struct SessionSnapshot
+{
+    juce::String pluginName;
+    juce::File bundle;
+    juce::Time bundleModificationTime;
+    juce::String bundleFingerprint; // See getBundleFingerprint()
+    juce::PluginDescription description;
+    juce::StringArray inputBuses;   // AudioChannelSet speaker arrangements
+    juce::StringArray outputBuses;
+    std::unique_ptr<juce::XmlElement> deviceState;
+    juce::MemoryBlock pluginState;
+    int windowWidth{0};
+    int windowHeight{0};
+
+    static juce::File getFileFor(const juce::String& pluginName);
+
+    // Size and modification time of Info.plist and everything in Contents/MacOS.
+    // Files replaced inside the bundle don't touch the bundle directory's own
+    // modification time, so that alone misses an in-place update.
+    static juce::String getBundleFingerprint(const juce::File& bundle);
+
+    // Records the bundle's modification time and fingerprint
+    void setBundle(const juce::File& bundle);
+
+    // True if the plugin name and the component bundle are unchanged
+    bool isValidFor(const juce::String& name) const;
+
+    void setBusesLayout(const juce::AudioProcessor::BusesLayout& layout);
+    juce::AudioProcessor::BusesLayout getBusesLayout() const;
+
+    bool save(const juce::File& file) const;
+    bool load(const juce::File& file);
+};
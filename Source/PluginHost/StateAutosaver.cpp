@@ -0,0 +1,245 @@
+#include "StateAutosaver.h"
+#include "PluginLoader.h"
+#include <algorithm>
+
+namespace
+{
+    const juce::Identifier autosaveId("TowelHostAutosave");
+    const juce::Identifier versionId("version");
+    const juce::Identifier pluginNameId("pluginName");
+    const juce::Identifier timeId("time");
+    const juce::Identifier stateId("state");
+
+    constexpr int currentVersion = 1;
+    const char* const wildcard = "*.autosave";
+
+    // Newest first; the names sort by time
+    juce::Array<juce::File> findAutosaveFiles(const juce::File& directory)
+    {
+        auto files = directory.findChildFiles(juce::File::findFiles, false, wildcard);
+        std::sort(files.begin(), files.end(), [](const juce::File& a, const juce::File& b)
+                  { return a.getFileName() > b.getFileName(); });
+        return files;
+    }
+
+    juce::String describeSize(size_t bytes)
+    {
+        return juce::File::descriptionOfSizeInBytes((juce::int64) bytes);
+    }
+}
+
+StateAutosaver::StateAutosaver(juce::AudioProcessor& p, const juce::String& name)
+    : juce::Thread("Autosave"),
+      processor(p),
+      pluginName(p.getName()),
+      directory(getDirectoryFor(name))
+{
+}
+
+StateAutosaver::~StateAutosaver()
+{
+    stop();
+}
+
+juce::File StateAutosaver::getDirectoryFor(const juce::String& name)
+{
+    return PluginLoader::getDataDirectory().getChildFile("Autosave").getChildFile(juce::File::createLegalFileName(name));
+}
+
+// Message thread, once the session's starting state is in place (after any
+// restore): that state is the baseline, so it's never written unchanged
+void StateAutosaver::start(double intervalSeconds)
+{
+    stop();
+
+    captured.reset();
+    processor.getStateInformation(captured);
+    lastHash = hashState(captured);
+    lastSize = captured.getSize();
+    busy.store(false);
+
+    directory.createDirectory();
+    startThread(3); // Below normal: it must never compete with the audio threads
+    startTimer(juce::jmax(1000, juce::roundToInt(intervalSeconds * 1000.0)));
+}
+
+void StateAutosaver::stop()
+{
+    stopTimer();
+    stopThread(10000); // Lets a running write finish; the temporary file covers the rest
+}
+
+void StateAutosaver::discard()
+{
+    for (auto& file : findAutosaveFiles(directory))
+        file.deleteFile();
+}
+
+// Message thread: the only part that touches the plugin
+void StateAutosaver::timerCallback()
+{
+    // The last write is still going; this check is skipped rather than queued
+    if (busy.load())
+        return;
+
+    const auto captureStart = juce::Time::getMillisecondCounterHiRes();
+    captured.reset();
+    processor.getStateInformation(captured);
+    captureMs = juce::Time::getMillisecondCounterHiRes() - captureStart;
+    checks.fetch_add(1);
+
+    if (captured.getSize() == 0)
+        return;
+
+    busy.store(true);
+    notify();
+}
+
+void StateAutosaver::run()
+{
+    while (!threadShouldExit())
+    {
+        wait(-1);
+
+        if (busy.load())
+        {
+            writeCapturedState();
+            busy.store(false);
+        }
+    }
+}
+
+void StateAutosaver::writeCapturedState()
+{
+    const auto hashStart = juce::Time::getMillisecondCounterHiRes();
+    const auto hash = hashState(captured);
+    const double hashMs = juce::Time::getMillisecondCounterHiRes() - hashStart;
+    const size_t size = captured.getSize();
+
+    if (hash == lastHash && size == lastSize)
+        return;
+
+    const auto now = juce::Time::getCurrentTime();
+    const auto file = directory.getChildFile(now.formatted("%Y%m%d-%H%M%S") + "-"
+                                             + juce::String(now.getMilliseconds()).paddedLeft('0', 3) + ".autosave");
+
+    const auto writeStart = juce::Time::getMillisecondCounterHiRes();
+    if (!writeFile(file))
+    {
+        juce::MessageManager::callAsync([file] { PluginLoader::LOG("Autosave: could not write " + file.getFullPathName()); });
+        return;
+    }
+    const double writeMs = juce::Time::getMillisecondCounterHiRes() - writeStart;
+
+    lastHash = hash;
+    lastSize = size;
+    writes.fetch_add(1);
+    removeOldAutosaves();
+
+    if (writeMs > largestWriteMs.load())
+        largestWriteMs.store(writeMs);
+    if (size > largestStateBytes.load())
+        largestStateBytes.store(size);
+
+    // Big states are where an autosave could cost something, so each one is on record
+    if (size >= largeStateBytes)
+    {
+        juce::String message;
+        message << "Autosave: " << describeSize(size) << " state captured in " << juce::String(captureMs, 1)
+                << " ms on the message thread, hashed in " << juce::String(hashMs, 1) << " ms, compressed to "
+                << describeSize((size_t) file.getSize()) << " and written in " << juce::String(writeMs, 1)
+                << " ms in the background";
+        juce::MessageManager::callAsync([message] { PluginLoader::LOG(message); });
+    }
+    else
+    {
+        DBG("Autosave: " + describeSize(size) + " written in " + juce::String(writeMs, 1) + " ms");
+    }
+}
+
+// Written next to the target and renamed, like the session snapshot
+bool StateAutosaver::writeFile(const juce::File& file) const
+{
+    juce::ValueTree tree(autosaveId);
+    tree.setProperty(versionId, currentVersion, nullptr);
+    tree.setProperty(pluginNameId, pluginName, nullptr);
+    tree.setProperty(timeId, juce::Time::currentTimeMillis(), nullptr);
+    tree.setProperty(stateId, captured, nullptr);
+
+    juce::TemporaryFile temp(file);
+    {
+        juce::FileOutputStream out(temp.getFile());
+        if (!out.openedOk())
+            return false;
+
+        // Fastest level: plugin states are mostly repetitive, and speed matters more here
+        juce::GZIPCompressorOutputStream compressed(out, 1);
+        tree.writeToStream(compressed);
+        compressed.flush();
+
+        if (out.getStatus().failed())
+            return false;
+    }
+
+    return temp.overwriteTargetFileWithTemporary();
+}
+
+void StateAutosaver::removeOldAutosaves() const
+{
+    auto files = findAutosaveFiles(directory);
+    for (int i = numKept; i < files.size(); ++i)
+        files.getReference(i).deleteFile();
+}
+
+std::unique_ptr<StateAutosaver::Autosave> StateAutosaver::findNewest(const juce::String& name)
+{
+    for (auto& file : findAutosaveFiles(getDirectoryFor(name)))
+    {
+        juce::FileInputStream in(file);
+        if (!in.openedOk())
+            continue;
+
+        juce::GZIPDecompressorInputStream decompressed(in);
+        auto tree = juce::ValueTree::readFromStream(decompressed);
+        if (!tree.hasType(autosaveId) || (int) tree.getProperty(versionId) != currentVersion)
+            continue;
+
+        auto* state = tree.getProperty(stateId).getBinaryData();
+        if (state == nullptr || state->getSize() == 0)
+            continue;
+
+        auto autosave = std::make_unique<Autosave>();
+        autosave->file = file;
+        autosave->time = juce::Time((juce::int64) tree.getProperty(timeId));
+        autosave->pluginName = tree.getProperty(pluginNameId).toString();
+        autosave->state = *state;
+        return autosave;
+    }
+
+    return nullptr;
+}
+
+// FNV-1a, as in the realtime auditor; only compared with the previous write
+juce::uint64 StateAutosaver::hashState(const juce::MemoryBlock& state)
+{
+    juce::uint64 hash = 14695981039346656037ull;
+    const auto* bytes = static_cast<const juce::uint8*>(state.getData());
+
+    for (size_t i = 0; i < state.getSize(); ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+juce::String StateAutosaver::getSummary() const
+{
+    juce::String summary;
+    summary << "Autosave: " << checks.load() << " check(s), " << writes.load() << " write(s)";
+    if (writes.load() > 0)
+        summary << "; largest state " << describeSize(largestStateBytes.load()) << ", slowest write "
+                << juce::String(largestWriteMs.load(), 1) << " ms";
+    return summary;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+
+// Periodic crash protection for the plugin's state (--autosave).
+//
+// A timer on the message thread captures getStateInformation() - never under
+// the engine's lock, so the audio thread keeps running - and hands the blob to
+// a low-priority thread. That thread hashes it and, only if the hash changed
+// since start() or the last write, gzips it to a temporary file and renames it over the
+// target, so a crash mid-write never leaves a broken autosave. The newest few
+// are kept per plugin.
+//
+// A clean quit discards them (the session snapshot covers that case), so any
+// autosave found at launch is from a session that didn't end normally.
+class StateAutosaver : private juce::Timer,
+                       private juce::Thread
+{
+public:
+    struct Autosave
+    {
+        juce::File file;
+        juce::Time time;
+        juce::String pluginName; // AudioProcessor::getName() of the saved instance
+        juce::MemoryBlock state;
+    };
+
+    StateAutosaver(juce::AudioProcessor& processor, const juce::String& hostName);
+    ~StateAutosaver() override;
+
+    // Captures and hashes the current state as the baseline, then starts checking
+    void start(double intervalSeconds);
+    void stop();
+
+    // Deletes every autosave for this host name
+    void discard();
+
+    // Newest readable autosave for a host name, or nullptr if there is none
+    static std::unique_ptr<Autosave> findNewest(const juce::String& hostName);
+
+    static juce::File getDirectoryFor(const juce::String& hostName);
+
+    // Checks, writes and the cost of the largest write, for the exit log
+    juce::String getSummary() const;
+
+private:
+    void timerCallback() override;
+    void run() override;
+    void writeCapturedState();
+    bool writeFile(const juce::File& file) const;
+    void removeOldAutosaves() const;
+
+    static juce::uint64 hashState(const juce::MemoryBlock& state);
+
+    static constexpr int numKept = 5;
+    static constexpr size_t largeStateBytes = 1024 * 1024; // Every write this size or more is logged
+
+    juce::AudioProcessor& processor;
+    const juce::String pluginName;
+    const juce::File directory;
+
+    // Written on the message thread while idle, read by the writer while busy
+    juce::MemoryBlock captured;
+    double captureMs{0.0};
+    std::atomic<bool> busy{false};
+
+    // Set by start() before the writer runs, then writer thread only
+    juce::uint64 lastHash{0};
+    size_t lastSize{0};
+
+    std::atomic<int> checks{0};
+    std::atomic<int> writes{0};
+    std::atomic<double> largestWriteMs{0.0};
+    std::atomic<size_t> largestStateBytes{0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StateAutosaver)
+};
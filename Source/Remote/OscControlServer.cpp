@@ -0,0 +1,305 @@
+#include "OscControlServer.h"
+#include "../PluginHost/PluginLoader.h"
+
+OscControlServer::OscControlServer(AudioEngine& engine) : audioEngine(engine) {}
+
+OscControlServer::~OscControlServer()
+{
+    setParameterRegistry(nullptr);
+    stop();
+    masterReference.clear();
+}
+
+juce::String OscControlServer::start(int port, const juce::String& bindAddress,
+                                     const juce::String& replyHost, int replyPort,
+                                     double telemetryRateHz)
+{
+    stop();
+
+    // Created here on the message thread; the receiver thread only copies it
+    selfReference = this;
+
+    // Bind explicitly so the server is only reachable from this machine by default
+    socket = std::make_unique<juce::DatagramSocket>(false);
+    if (!socket->bindToPort(port, bindAddress))
+    {
+        socket = nullptr;
+        return "Could not bind OSC port " + juce::String(port) + " on " + bindAddress;
+    }
+
+    if (!receiver.connectToSocket(*socket))
+    {
+        socket = nullptr;
+        return "Could not start OSC receiver on port " + juce::String(port);
+    }
+
+    receiver.addListener(this);
+
+    senderConnected = replyPort > 0 && sender.connect(replyHost, replyPort);
+    if (senderConnected && telemetryRateHz > 0.0)
+        startTimer(juce::jmax(1, juce::roundToInt(1000.0 / telemetryRateHz)));
+
+    PluginLoader::LOG("OSC control listening on " + bindAddress + ":" + juce::String(port)
+                      + (senderConnected ? ", telemetry to " + replyHost + ":" + juce::String(replyPort)
+                                         : juce::String(", telemetry disabled")));
+    return {};
+}
+
+void OscControlServer::setParameterRegistry(ParameterRegistry* registry)
+{
+    ParameterRegistry* previous = nullptr;
+    {
+        // Once this returns the receiver thread can't be using the previous one
+        const juce::ScopedLock sl(registryLock);
+        previous = parameterRegistry;
+        parameterRegistry = registry;
+    }
+
+    if (previous != nullptr)
+        previous->removeListener(this);
+
+    if (registry != nullptr)
+        registry->addListener(this);
+}
+
+void OscControlServer::stop()
+{
+    stopTimer();
+
+    receiver.removeListener(this);
+    receiver.disconnect();
+    socket = nullptr;
+
+    if (senderConnected)
+    {
+        const juce::ScopedLock sl(senderLock);
+        sender.disconnect();
+    }
+    senderConnected = false;
+}
+
+// Runs on the OSC receiver thread
+void OscControlServer::oscMessageReceived(const juce::OSCMessage& message)
+{
+    const auto address = message.getAddressPattern().toString();
+
+    auto intArg = [&message](int i) -> int
+    {
+        if (i >= message.size()) return 0;
+        if (message[i].isInt32()) return message[i].getInt32();
+        if (message[i].isFloat32()) return juce::roundToInt(message[i].getFloat32());
+        return 0;
+    };
+
+    auto floatArg = [&message](int i) -> float
+    {
+        if (i >= message.size()) return 0.0f;
+        if (message[i].isFloat32()) return message[i].getFloat32();
+        if (message[i].isInt32()) return (float) message[i].getInt32();
+        return 0.0f;
+    };
+
+    auto stringArg = [&message](int i) -> juce::String
+    {
+        return i < message.size() && message[i].isString() ? message[i].getString() : juce::String();
+    };
+
+    if (address == "/towelhost/param" && message.size() >= 2)
+    {
+        postCommand(EngineCommand::Type::SetParameter, intArg(0), floatArg(1));
+    }
+    else if (address == "/towelhost/param/id" && message.size() >= 2)
+    {
+        // The registry's maps are immutable, so the lookup itself is safe on this
+        // thread; the lock only keeps the registry from being replaced and freed
+        // meanwhile. The command names the registry's plugin, so a slot switch in
+        // between can't send the index to a different plugin.
+        int index = -1;
+        juce::AudioProcessor* processor = nullptr;
+        {
+            const juce::ScopedLock sl(registryLock);
+            if (parameterRegistry != nullptr)
+            {
+                index = parameterRegistry->indexOfID(stringArg(0));
+                processor = &parameterRegistry->getProcessor();
+            }
+        }
+
+        if (index >= 0)
+            postCommand(EngineCommand::Type::SetParameter, index, floatArg(1), processor);
+        else
+            DBG("OSC: unknown parameter ID " + stringArg(0));
+    }
+    else if (address == "/towelhost/bypass")
+    {
+        postCommand(EngineCommand::Type::SetBypass, 0, intArg(0) != 0 ? 1.0f : 0.0f);
+    }
+    else if (address == "/towelhost/slot")
+    {
+        const int slot = intArg(0);
+        auto weakThis = selfReference;
+
+        juce::MessageManager::callAsync([weakThis, slot]
+        {
+            if (auto* server = weakThis.get())
+            {
+                if (server->onSlotSelect)
+                    server->onSlotSelect(slot);
+                else
+                    server->audioEngine.selectSlot(slot);
+            }
+        });
+    }
+    else if (address == "/towelhost/preset")
+    {
+        juce::File presetFile(stringArg(0));
+        auto weakThis = selfReference;
+
+        juce::MessageManager::callAsync([weakThis, presetFile]
+        {
+            if (auto* server = weakThis.get())
+                if (server->onPresetLoad)
+                    server->onPresetLoad(presetFile);
+        });
+    }
+    else if (address == "/towelhost/device/samplerate")
+    {
+        changeDeviceSetupAsync(floatArg(0), 0, {});
+    }
+    else if (address == "/towelhost/device/buffersize")
+    {
+        changeDeviceSetupAsync(0.0, intArg(0), {});
+    }
+    else if (address == "/towelhost/device/name")
+    {
+        changeDeviceSetupAsync(0.0, 0, stringArg(0));
+    }
+    else if (address == "/towelhost/latency/measure")
+    {
+        measureLatencyAsync(message.size() >= 1 ? intArg(0) - 1 : 0, message.size() >= 2 ? intArg(1) - 1 : 0);
+    }
+    else if (address == "/towelhost/trace/dump")
+    {
+        const auto path = stringArg(0);
+        auto weakThis = selfReference;
+
+        juce::MessageManager::callAsync([weakThis, path]
+        {
+            if (auto* server = weakThis.get())
+                if (server->onTraceDump)
+                    server->onTraceDump(path.isNotEmpty() ? juce::File::getCurrentWorkingDirectory().getChildFile(path) : juce::File());
+        });
+    }
+    else if (address == "/towelhost/flight/dump")
+    {
+        // Only sets a flag the recorder's thread polls
+        audioEngine.getFlightRecorder().requestDump();
+    }
+    else
+    {
+        DBG("OSC: unhandled message " + address);
+    }
+}
+
+void OscControlServer::postCommand(EngineCommand::Type type, int index, float value, juce::AudioProcessor* processor)
+{
+    EngineCommand command;
+    command.type = type;
+    command.index = index;
+    command.value = value;
+    command.processor = processor;
+
+    if (!audioEngine.postCommand(command))
+        DBG("OSC: engine command queue full, message dropped");
+}
+
+void OscControlServer::changeDeviceSetupAsync(double sampleRate, int bufferSize, const juce::String& deviceName)
+{
+    auto weakThis = selfReference;
+
+    juce::MessageManager::callAsync([weakThis, sampleRate, bufferSize, deviceName]
+    {
+        if (auto* server = weakThis.get())
+        {
+            auto error = server->audioEngine.changeDeviceSetup(sampleRate, bufferSize, deviceName);
+            if (error.isNotEmpty())
+                PluginLoader::LOG("OSC: device change failed: " + error);
+        }
+    });
+}
+
+void OscControlServer::measureLatencyAsync(int outputChannel, int inputChannel)
+{
+    auto weakThis = selfReference;
+
+    juce::MessageManager::callAsync([weakThis, outputChannel, inputChannel]
+    {
+        auto* server = weakThis.get();
+        if (server == nullptr)
+            return;
+
+        auto error = server->audioEngine.measureLatency(outputChannel, inputChannel, [weakThis](const LatencyProbe::Result& result)
+        {
+            PluginLoader::LOG(result.toString());
+
+            auto* s = weakThis.get();
+            if (s == nullptr || !s->senderConnected)
+                return;
+
+            if (result.succeeded)
+                s->send("/towelhost/latency", (juce::int32) result.measuredSamples,
+                        (juce::int32) result.getExpectedSamples(), (float) result.confidence);
+            else
+                s->send("/towelhost/latency/error", result.error);
+        });
+
+        if (error.isNotEmpty() && server->senderConnected)
+            server->send("/towelhost/latency/error", error);
+    });
+}
+
+// Message thread, once per UI frame with every parameter that changed
+void OscControlServer::parametersChanged(const ParameterRegistry& registry, const juce::Array<int>& changedIndices)
+{
+    if (!senderConnected)
+        return;
+
+    // Split so large preset changes stay well inside one UDP datagram
+    constexpr int maxPairsPerMessage = 256;
+
+    for (int start = 0; start < changedIndices.size(); start += maxPairsPerMessage)
+    {
+        juce::OSCMessage message("/towelhost/params");
+
+        for (int i = start; i < juce::jmin(start + maxPairsPerMessage, changedIndices.size()); ++i)
+        {
+            const int index = changedIndices.getUnchecked(i);
+            message.addInt32((juce::int32) index);
+            message.addFloat32(registry.getValue(index));
+        }
+
+        send(message);
+    }
+}
+
+// Runs on the timer thread; only reads the engine's atomics
+void OscControlServer::hiResTimerCallback()
+{
+    send("/towelhost/load", (float) audioEngine.getCpuLoad());
+
+    juce::OSCMessage meters("/towelhost/meters");
+    for (int ch = 0; ch < audioEngine.getNumOutputChannels(); ++ch)
+        meters.addFloat32(audioEngine.getOutputPeak(ch));
+    send(meters);
+
+    send("/towelhost/xruns", (juce::int32) audioEngine.getDeviceXRunCount(),
+                             (juce::int32) audioEngine.getEngineXRunCount());
+
+    if (auto* renderAhead = audioEngine.getRenderAhead())
+        send("/towelhost/renderahead", (float) renderAhead->getAheadUsedMs(), (float) renderAhead->getAheadMs(),
+                                       (juce::int32) renderAhead->getUnderrunCount());
+
+    if (audioEngine.isSkippingSilence())
+        send("/towelhost/skipped", (juce::int32) audioEngine.getSkippedBlockCount(),
+                                   (juce::int32) audioEngine.getSlotBlockCount());
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <JuceHeader.h>
+#include "../Audio/AudioEngine.h"
+#include "../PluginHost/ParameterRegistry.h"
+
+// Optional OSC control and telemetry endpoint for running TowelHost from
+// external tooling.
+//
+// Incoming messages are handled on the OSC receiver's own thread. Parameter
+// and bypass changes go to the audio thread through AudioEngine's lock-free
+// command queue; preset loads and device changes are forwarded to the
+// message thread. Nothing here takes a lock the audio callback uses; replies
+// from the timer and message threads share one lock around the sender.
+//
+// Address space:
+//   /towelhost/param <int index> <float value 0..1>
+//   /towelhost/param/id <string parameter ID> <float value 0..1>
+//   /towelhost/bypass <int 0|1>
+//   /towelhost/slot <int slot>
+//   /towelhost/preset <string path>
+//   /towelhost/device/samplerate <float Hz>
+//   /towelhost/device/buffersize <int samples>
+//   /towelhost/device/name <string output device>
+//   /towelhost/latency/measure [<int output> <int input>]   (1-based, default 1 1)
+//   /towelhost/trace/dump [<string path>]
+//   /towelhost/flight/dump
+//
+// Telemetry sent to the reply address:
+//   /towelhost/load <float 0..1>
+//   /towelhost/meters <float peak>...   (one per output channel)
+//   /towelhost/xruns <int device> <int engine>
+//   /towelhost/renderahead <float ms used> <float ms ahead> <int underruns>   (render-ahead only)
+//   /towelhost/latency <int measured> <int reported> <float confidence>
+//   /towelhost/latency/error <string>
+//   /towelhost/params <int index> <float value>...   (changed parameters, once per UI frame)
+class OscControlServer : private juce::OSCReceiver::Listener<juce::OSCReceiver::RealtimeCallback>,
+                         private juce::HighResolutionTimer,
+                         private ParameterRegistry::Listener
+{
+public:
+    explicit OscControlServer(AudioEngine& engine);
+    ~OscControlServer() override;
+
+    // Binds the control socket and starts sending telemetry. Returns an
+    // error message, or an empty string on success.
+    juce::String start(int port, const juce::String& bindAddress,
+                       const juce::String& replyHost, int replyPort,
+                       double telemetryRateHz);
+    void stop();
+
+    // Enables /towelhost/param/id and parameter change reports; message thread only.
+    // Once this returns the server no longer uses the previous registry, so it
+    // can be freed. The current one must outlive the server or be replaced first.
+    void setParameterRegistry(ParameterRegistry* registry);
+
+    // Called on the message thread when a preset file should be loaded
+    std::function<void(const juce::File&)> onPresetLoad;
+
+    // Called on the message thread for /towelhost/slot, so the host can switch
+    // the editor and the published registry too; without it the engine switches alone
+    std::function<void(int)> onSlotSelect;
+
+    // Called on the message thread when the trace should be written; the file
+    // is empty if the message didn't name one
+    std::function<void(const juce::File&)> onTraceDump;
+
+private:
+    void oscMessageReceived(const juce::OSCMessage& message) override;
+    void hiResTimerCallback() override;
+    void parametersChanged(const ParameterRegistry& registry, const juce::Array<int>& changedIndices) override;
+
+    void postCommand(EngineCommand::Type type, int index, float value, juce::AudioProcessor* processor = nullptr);
+    void changeDeviceSetupAsync(double sampleRate, int bufferSize, const juce::String& deviceName);
+    void measureLatencyAsync(int outputChannel, int inputChannel);
+
+    // OSCSender isn't thread-safe, and telemetry is sent from the timer thread
+    // while parameter and latency replies come from the message thread
+    template <typename... Args>
+    void send(Args&&... args)
+    {
+        const juce::ScopedLock sl(senderLock);
+        sender.send(std::forward<Args>(args)...);
+    }
+
+    AudioEngine& audioEngine;
+    std::unique_ptr<juce::DatagramSocket> socket;
+    juce::OSCReceiver receiver;
+    juce::OSCSender sender;
+    juce::CriticalSection senderLock; // Never taken on the audio thread
+    bool senderConnected{false};
+    ParameterRegistry* parameterRegistry{nullptr};
+    juce::CriticalSection registryLock; // Receiver and message thread only
+    juce::WeakReference<OscControlServer> selfReference;
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE(OscControlServer)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OscControlServer)
+};
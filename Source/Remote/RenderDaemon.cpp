@@ -0,0 +1,522 @@
+#include "RenderDaemon.h"
+#include "../Audio/MidiFileSequencer.h"
+#include "../PluginHost/PluginLoader.h"
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+    double ticksToMs(juce::int64 ticks)
+    {
+        return juce::Time::highResolutionTicksToSeconds(ticks) * 1000.0;
+    }
+
+    bool makeAddress(const juce::File& file, sockaddr_un& address)
+    {
+        const auto path = file.getFullPathName().toStdString();
+        if (path.size() >= sizeof(address.sun_path))
+            return false;
+
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        return true;
+    }
+
+    juce::var makeError(const juce::var& id, const juce::String& error)
+    {
+        auto* reply = new juce::DynamicObject();
+        reply->setProperty("id", id);
+        reply->setProperty("ok", false);
+        reply->setProperty("error", error);
+        return juce::var(reply);
+    }
+}
+
+//==============================================================================
+// One client; jobs hold a reference so their replies can still be sent
+// after the reader has moved on
+class RenderDaemon::Connection
+{
+public:
+    explicit Connection(int socketFd) : fd(socketFd)
+    {
+       #ifdef SO_NOSIGPIPE
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+       #endif
+    }
+
+    ~Connection() { ::close(fd); }
+
+    // Any thread; a reply is written whole even if several workers finish at once
+    void send(const juce::var& reply)
+    {
+        const auto text = juce::JSON::toString(reply, true) + "\n";
+        const char* data = text.toRawUTF8();
+        size_t remaining = text.getNumBytesAsUTF8();
+
+       #ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;
+       #else
+        const int flags = 0;
+       #endif
+
+        const juce::ScopedLock sl(writeLock);
+        while (remaining > 0)
+        {
+            const auto written = ::send(fd, data, remaining, flags);
+            if (written <= 0)
+                return; // Client has gone; the job still ran
+
+            data += written;
+            remaining -= (size_t) written;
+        }
+    }
+
+    const int fd;
+
+private:
+    juce::CriticalSection writeLock;
+
+    JUCE_DECLARE_NON_COPYABLE(Connection)
+};
+
+//==============================================================================
+class RenderDaemon::Worker : public juce::Thread
+{
+public:
+    Worker(RenderDaemon& ownerDaemon, juce::AudioPluginInstance& pluginInstance, int workerIndex)
+        : juce::Thread("Render worker " + juce::String(workerIndex)),
+          daemon(ownerDaemon), plugin(pluginInstance), index(workerIndex)
+    {
+        // Jobs without a state start from the state the plugin had when the daemon started
+        plugin.getStateInformation(defaultState);
+        formatManager.registerBasicFormats();
+    }
+
+    ~Worker() override { stopThread(10000); }
+
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            Job job;
+            if (!daemon.takeNextJob(job))
+            {
+                daemon.jobAvailable.wait(100);
+                continue;
+            }
+
+            const auto startTicks = juce::Time::getHighResolutionTicks();
+            auto reply = render(job.request);
+
+            if (auto* object = reply.getDynamicObject())
+            {
+                object->setProperty("worker", index);
+                object->setProperty("queuedMs", ticksToMs(startTicks - job.queuedTicks));
+                object->setProperty("totalMs", ticksToMs(juce::Time::getHighResolutionTicks() - job.queuedTicks));
+            }
+
+            job.connection->send(reply);
+        }
+
+        plugin.releaseResources();
+    }
+
+private:
+    juce::var render(const juce::var& request)
+    {
+        const auto id = request["id"];
+        const juce::String inputPath = request["input"].toString();
+        const juce::String midiPath = request["midi"].toString();
+        const juce::String outputPath = request["output"].toString();
+
+        if (!juce::File::isAbsolutePath(outputPath))
+            return makeError(id, "\"output\" must be an absolute path");
+
+        if (inputPath.isEmpty() == midiPath.isEmpty())
+            return makeError(id, "give either \"input\" or \"midi\"");
+
+        if (!juce::File::isAbsolutePath(inputPath.isNotEmpty() ? inputPath : midiPath))
+            return makeError(id, "input paths must be absolute");
+
+        // Source
+        std::unique_ptr<juce::AudioFormatReader> reader;
+        MidiFileSequencer sequence;
+        double sampleRate = request.hasProperty("sampleRate") ? (double) request["sampleRate"] : 48000.0;
+        double lengthSeconds = 0.0;
+
+        if (inputPath.isNotEmpty())
+        {
+            reader.reset(formatManager.createReaderFor(juce::File(inputPath)));
+            if (reader == nullptr)
+                return makeError(id, "could not read " + inputPath);
+
+            // Audio files render at their own rate; there is no resampling
+            sampleRate = reader->sampleRate;
+            lengthSeconds = (double) reader->lengthInSamples / sampleRate;
+        }
+        else
+        {
+            auto error = sequence.load(juce::File(midiPath));
+            if (error.isNotEmpty())
+                return makeError(id, error);
+
+            sequence.setLooping(false);
+            lengthSeconds = sequence.getLengthInSeconds();
+        }
+
+        const int blockSize = request.hasProperty("blockSize") ? juce::jlimit(16, 16384, (int) request["blockSize"]) : 512;
+        const double tailSeconds = request.hasProperty("tail") ? juce::jlimit(0.0, 60.0, (double) request["tail"])
+                                                               : (midiPath.isNotEmpty() ? 2.0 : 0.0);
+
+        if (sampleRate < 8000.0 || sampleRate > 768000.0)
+            return makeError(id, "unsupported sample rate");
+
+        // State
+        juce::MemoryBlock state;
+        if (request.hasProperty("stateBase64"))
+        {
+            if (!state.fromBase64Encoding(request["stateBase64"].toString()))
+                return makeError(id, "\"stateBase64\" is not valid base64");
+        }
+        else if (request.hasProperty("state"))
+        {
+            const juce::String statePath = request["state"].toString();
+            if (!juce::File::isAbsolutePath(statePath) || !juce::File(statePath).loadFileAsData(state))
+                return makeError(id, "could not read state " + statePath);
+        }
+        else
+        {
+            state = defaultState;
+        }
+
+        const auto prepareStart = juce::Time::getHighResolutionTicks();
+
+        const int numInputs = plugin.getTotalNumInputChannels();
+        const int numOutputs = juce::jmax(1, plugin.getTotalNumOutputChannels());
+        const int numChannels = juce::jmax(numInputs, numOutputs);
+
+        plugin.setNonRealtime(true);
+        plugin.setPlayConfigDetails(numInputs, numOutputs, sampleRate, blockSize);
+        plugin.prepareToPlay(sampleRate, blockSize);
+        if (state.getSize() > 0)
+            plugin.setStateInformation(state.getData(), (int) state.getSize());
+        plugin.reset();
+        sequence.prepare(sampleRate);
+
+        const double stateMs = ticksToMs(juce::Time::getHighResolutionTicks() - prepareStart);
+
+        // Output
+        juce::File outputFile(outputPath);
+        outputFile.deleteFile();
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(new juce::FileOutputStream(outputFile),
+                                                                            sampleRate, (unsigned int) numOutputs,
+                                                                            32, {}, 0));
+        if (writer == nullptr)
+            return makeError(id, "could not write " + outputPath);
+
+        // Render
+        const auto totalSamples = (juce::int64) ((lengthSeconds + tailSeconds) * sampleRate);
+        const int numFileChannels = reader != nullptr ? (int) reader->numChannels : 0;
+
+        juce::AudioBuffer<float> block(numChannels, blockSize);
+        juce::AudioBuffer<float> fileBlock(juce::jmax(1, numFileChannels), blockSize);
+        juce::MidiBuffer midi;
+        midi.ensureSize(4096);
+
+        double maxBlockMs = 0.0;
+        bool written = true;
+        const auto renderStart = juce::Time::getHighResolutionTicks();
+
+        for (juce::int64 position = 0; position < totalSamples && written && !threadShouldExit(); position += blockSize)
+        {
+            const int numSamples = (int) juce::jmin((juce::int64) blockSize, totalSamples - position);
+            juce::AudioBuffer<float> view(block.getArrayOfWritePointers(), numChannels, numSamples);
+            view.clear();
+            midi.clear();
+
+            if (reader != nullptr && position < reader->lengthInSamples)
+            {
+                reader->read(&fileBlock, 0, numSamples, position, true, true);
+
+                // A mono file feeds every input
+                for (int ch = 0; ch < numInputs; ++ch)
+                    view.copyFrom(ch, 0, fileBlock, ch % numFileChannels, 0, numSamples);
+            }
+            else
+            {
+                sequence.renderNextBlock(midi, numSamples);
+            }
+
+            const auto blockStart = juce::Time::getHighResolutionTicks();
+            plugin.processBlock(view, midi);
+            maxBlockMs = juce::jmax(maxBlockMs, ticksToMs(juce::Time::getHighResolutionTicks() - blockStart));
+
+            written = writer->writeFromAudioSampleBuffer(view, 0, numSamples);
+        }
+
+        const double renderMs = ticksToMs(juce::Time::getHighResolutionTicks() - renderStart);
+        writer = nullptr;
+        plugin.setNonRealtime(false);
+
+        if (!written)
+            return makeError(id, "could not write " + outputPath);
+
+        if (threadShouldExit())
+            return makeError(id, "daemon is shutting down");
+
+        const double seconds = (double) totalSamples / sampleRate;
+
+        auto* reply = new juce::DynamicObject();
+        reply->setProperty("id", id);
+        reply->setProperty("ok", true);
+        reply->setProperty("stateMs", stateMs);
+        reply->setProperty("renderMs", renderMs);
+        reply->setProperty("seconds", seconds);
+        reply->setProperty("realtime", renderMs > 0.0 ? seconds * 1000.0 / renderMs : 0.0);
+        reply->setProperty("maxBlockMs", maxBlockMs);
+        return juce::var(reply);
+    }
+
+    RenderDaemon& daemon;
+    juce::AudioPluginInstance& plugin;
+    const int index;
+    juce::MemoryBlock defaultState;
+    juce::AudioFormatManager formatManager;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Worker)
+};
+
+//==============================================================================
+// Accepts clients and reads their lines; each client gets its own reader thread
+class RenderDaemon::Listener : public juce::Thread
+{
+public:
+    Listener(RenderDaemon& ownerDaemon, int socketFd)
+        : juce::Thread("Render daemon listener"), daemon(ownerDaemon), fd(socketFd) {}
+
+    ~Listener() override
+    {
+        stopThread(2000);
+        readers.clear(); // Stops every reader
+        ::close(fd);
+    }
+
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            pollfd pfd { fd, POLLIN, 0 };
+            if (poll(&pfd, 1, 100) <= 0)
+                continue;
+
+            const int clientFd = ::accept(fd, nullptr, nullptr);
+            if (clientFd < 0)
+                continue;
+
+            // Finished readers are cleaned up as new clients arrive
+            for (int i = readers.size(); --i >= 0;)
+                if (!readers.getUnchecked(i)->isThreadRunning())
+                    readers.remove(i);
+
+            auto* reader = readers.add(new Reader(daemon, std::make_shared<Connection>(clientFd)));
+            reader->startThread();
+        }
+    }
+
+private:
+    class Reader : public juce::Thread
+    {
+    public:
+        Reader(RenderDaemon& ownerDaemon, std::shared_ptr<Connection> clientConnection)
+            : juce::Thread("Render daemon client"), daemon(ownerDaemon), connection(std::move(clientConnection)) {}
+
+        ~Reader() override { stopThread(2000); }
+
+        void run() override
+        {
+            juce::MemoryOutputStream pending;
+            char data[4096];
+
+            while (!threadShouldExit())
+            {
+                pollfd pfd { connection->fd, POLLIN, 0 };
+                if (poll(&pfd, 1, 100) <= 0)
+                    continue;
+
+                const auto numRead = ::recv(connection->fd, data, sizeof(data), 0);
+                if (numRead <= 0)
+                    break; // Client closed; queued jobs keep the connection alive for their replies
+
+                for (ssize_t i = 0; i < numRead; ++i)
+                {
+                    if (data[i] != '\n')
+                    {
+                        pending.writeByte(data[i]);
+                        continue;
+                    }
+
+                    const auto line = pending.toUTF8().trim();
+                    pending.reset();
+
+                    if (line.isNotEmpty())
+                        daemon.handleLine(connection, line);
+                }
+            }
+        }
+
+    private:
+        RenderDaemon& daemon;
+        std::shared_ptr<Connection> connection;
+    };
+
+    RenderDaemon& daemon;
+    const int fd;
+    juce::OwnedArray<Reader> readers;
+};
+
+//==============================================================================
+RenderDaemon::RenderDaemon(const juce::Array<juce::AudioPluginInstance*>& instances)
+    : jobAvailable(false)
+{
+    for (auto* instance : instances)
+        workers.add(new Worker(*this, *instance, workers.size()));
+}
+
+RenderDaemon::~RenderDaemon()
+{
+    stop();
+}
+
+juce::String RenderDaemon::start(const juce::File& file)
+{
+    sockaddr_un address;
+    if (!makeAddress(file, address))
+        return "Socket path is too long: " + file.getFullPathName();
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return "Could not create socket";
+
+    // A socket file nobody answers on is left over from a crash
+    if (::connect(fd, (const sockaddr*) &address, sizeof(address)) == 0)
+    {
+        ::close(fd);
+        return "Another daemon is already listening on " + file.getFullPathName();
+    }
+
+    ::close(fd);
+    file.deleteFile();
+
+    const int listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0
+        || ::bind(listenFd, (const sockaddr*) &address, sizeof(address)) != 0
+        || ::listen(listenFd, 16) != 0)
+    {
+        if (listenFd >= 0)
+            ::close(listenFd);
+        return "Could not listen on " + file.getFullPathName();
+    }
+
+    socketFile = file;
+
+    for (auto* worker : workers)
+        worker->startThread();
+
+    listener = std::make_unique<Listener>(*this, listenFd);
+    listener->startThread();
+
+    return {};
+}
+
+void RenderDaemon::stop()
+{
+    listener = nullptr; // No new jobs
+
+    for (auto* worker : workers)
+        worker->signalThreadShouldExit();
+    jobAvailable.signal();
+    workers.clear(); // Waits for the running jobs
+
+    {
+        const juce::ScopedLock sl(queueLock);
+        for (auto& job : queue)
+            job.connection->send(makeError(job.request["id"], "daemon is shutting down"));
+        queue.clear();
+    }
+
+    if (socketFile != juce::File())
+        socketFile.deleteFile();
+    socketFile = juce::File();
+}
+
+// Reader threads
+void RenderDaemon::handleLine(const std::shared_ptr<Connection>& connection, const juce::String& line)
+{
+    const auto request = juce::JSON::parse(line);
+    if (!request.isObject())
+    {
+        connection->send(makeError({}, "not a JSON object"));
+        return;
+    }
+
+    const juce::String command = request["command"].toString();
+
+    if (command == "status")
+    {
+        auto* reply = new juce::DynamicObject();
+        reply->setProperty("id", request["id"]);
+        reply->setProperty("ok", true);
+        reply->setProperty("plugin", PluginLoader::getExecutableName());
+        reply->setProperty("workers", workers.size());
+        {
+            const juce::ScopedLock sl(queueLock);
+            reply->setProperty("queued", (int) queue.size());
+        }
+        connection->send(juce::var(reply));
+    }
+    else if (command == "quit")
+    {
+        auto* reply = new juce::DynamicObject();
+        reply->setProperty("id", request["id"]);
+        reply->setProperty("ok", true);
+        connection->send(juce::var(reply));
+
+        juce::MessageManager::callAsync([] { juce::JUCEApplicationBase::quit(); });
+    }
+    else if (command.isNotEmpty())
+    {
+        connection->send(makeError(request["id"], "unknown command " + command));
+    }
+    else
+    {
+        {
+            const juce::ScopedLock sl(queueLock);
+            queue.push_back({ connection, request, juce::Time::getHighResolutionTicks() });
+        }
+        jobAvailable.signal();
+    }
+}
+
+// Worker threads
+bool RenderDaemon::takeNextJob(Job& job)
+{
+    const juce::ScopedLock sl(queueLock);
+    if (queue.empty())
+        return false;
+
+    job = std::move(queue.front());
+    queue.pop_front();
+
+    // More work left: wake another worker too
+    if (!queue.empty())
+        jobAvailable.signal();
+
+    return true;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <JuceHeader.h>
+#include <deque>
+#include <memory>
+
+// Daemon mode (--daemon): keeps prepared plugin instances resident and
+// renders jobs sent over a local Unix socket, so the plugin's load and
+// scan cost is paid once rather than once per job.
+//
+// Each worker thread owns one instance. Jobs from every connection go into
+// one queue and the next free worker takes the next job. Each instance is
+// only ever used by its own worker.
+//
+// Protocol: one JSON object per line in each direction. A job:
+//   {"id": 1, "input": "/path/in.wav", "output": "/path/out.wav"}
+//   {"id": 2, "midi": "/path/song.mid", "state": "/path/preset.bin", "output": "/path/out.wav",
+//    "sampleRate": 48000, "blockSize": 512, "tail": 2.0}
+// Paths must be absolute. "input" (an audio file, rendered at its own sample
+// rate) or "midi" selects the source; "sampleRate" only applies to MIDI jobs,
+// and "tail" defaults to 2 s for MIDI and 0 for audio. The optional "state"
+// is a file written by getStateInformation(), or "stateBase64" the same blob
+// inline; without one the job starts from the state the plugin had when the
+// daemon started.
+//
+// Every job gets one reply, in completion order, with its id:
+//   {"id": 1, "ok": true, "worker": 0, "queuedMs": 0.1, "stateMs": 2.3,
+//    "renderMs": 812.5, "totalMs": 815.0, "seconds": 10.0, "realtime": 12.3,
+//    "maxBlockMs": 1.2}
+//   {"id": 2, "ok": false, "error": "..."}
+// {"command": "status"} replies with the worker and queue counts, and
+// {"command": "quit"} shuts the app down.
+class RenderDaemon
+{
+public:
+    // The instances must outlive the daemon; one worker is started per instance
+    explicit RenderDaemon(const juce::Array<juce::AudioPluginInstance*>& instances);
+    ~RenderDaemon();
+
+    // Creates the socket and starts accepting connections. Returns an error
+    // message, or an empty string on success.
+    juce::String start(const juce::File& socketFile);
+    void stop();
+
+    int getNumWorkers() const { return workers.size(); }
+
+private:
+    class Connection;
+    class Worker;
+    class Listener;
+
+    struct Job
+    {
+        std::shared_ptr<Connection> connection;
+        juce::var request;
+        juce::int64 queuedTicks{0};
+    };
+
+    void handleLine(const std::shared_ptr<Connection>& connection, const juce::String& line);
+    bool takeNextJob(Job& job);
+
+    juce::OwnedArray<Worker> workers;
+    std::unique_ptr<Listener> listener;
+    juce::File socketFile;
+
+    juce::CriticalSection queueLock;
+    std::deque<Job> queue;
+    juce::WaitableEvent jobAvailable;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RenderDaemon)
+};
@@ -0,0 +1,119 @@
+#include "AnalyzerComponent.h"
+#include "../Audio/AudioEngine.h"
+
+namespace
+{
+    constexpr float minFrequency = 20.0f;
+    constexpr float maxFrequency = 20000.0f;
+    constexpr float minDb = -100.0f;
+    constexpr float maxDb = 0.0f;
+}
+
+AnalyzerComponent::AnalyzerComponent(AudioEngine& engine, bool drawAsOverlay)
+    : analyzer(engine.getAnalyzerTap()), isOverlay(drawAsOverlay)
+{
+    setOpaque(!isOverlay);
+
+    // An overlay must never take clicks meant for the plugin's editor
+    setInterceptsMouseClicks(false, false);
+
+    analyzer.start(engine.getCurrentSampleRate());
+    startTimerHz(frameRateHz);
+}
+
+AnalyzerComponent::~AnalyzerComponent()
+{
+    stopTimer();
+    analyzer.stop();
+}
+
+void AnalyzerComponent::timerCallback()
+{
+    if (analyzer.getLatestFrame(frame))
+        repaint();
+}
+
+void AnalyzerComponent::paint(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+
+    g.setColour(juce::Colours::black.withAlpha(isOverlay ? 0.6f : 1.0f));
+    g.fillRect(bounds);
+
+    auto scopeArea = bounds.removeFromBottom(bounds.getHeight() * 0.3f);
+    paintSpectrum(g, bounds.reduced(4.0f));
+    paintScope(g, scopeArea.reduced(4.0f));
+}
+
+void AnalyzerComponent::paintSpectrum(juce::Graphics& g, juce::Rectangle<float> area)
+{
+    const float nyquist = (float) frame.sampleRate * 0.5f;
+    const float logRange = std::log(maxFrequency / minFrequency);
+
+    auto xForFrequency = [&](float frequency)
+    {
+        return area.getX() + area.getWidth() * std::log(frequency / minFrequency) / logRange;
+    };
+
+    auto yForDb = [&](float db)
+    {
+        return juce::jmap(juce::jlimit(minDb, maxDb, db), minDb, maxDb, area.getBottom(), area.getY());
+    };
+
+    // Grid: decades and every 20 dB
+    g.setColour(juce::Colours::white.withAlpha(0.15f));
+    for (float frequency : { 100.0f, 1000.0f, 10000.0f })
+        g.drawVerticalLine(juce::roundToInt(xForFrequency(frequency)), area.getY(), area.getBottom());
+    for (float db = minDb + 20.0f; db < maxDb; db += 20.0f)
+        g.drawHorizontalLine(juce::roundToInt(yForDb(db)), area.getX(), area.getRight());
+
+    auto makePath = [&](const std::array<float, SpectrumAnalyzer::numBins>& values)
+    {
+        juce::Path path;
+        bool started = false;
+
+        for (int bin = 1; bin < SpectrumAnalyzer::numBins; ++bin)
+        {
+            const float frequency = nyquist * (float) bin / (float) SpectrumAnalyzer::numBins;
+            if (frequency < minFrequency || frequency > maxFrequency)
+                continue;
+
+            const juce::Point<float> point(xForFrequency(frequency), yForDb(values[(size_t) bin]));
+            if (started)
+                path.lineTo(point);
+            else
+                path.startNewSubPath(point);
+            started = true;
+        }
+
+        return path;
+    };
+
+    g.setColour(juce::Colours::orange.withAlpha(0.5f));
+    g.strokePath(makePath(frame.peakDb), juce::PathStrokeType(1.0f));
+
+    g.setColour(juce::Colours::lightgreen);
+    g.strokePath(makePath(frame.spectrumDb), juce::PathStrokeType(1.5f));
+}
+
+void AnalyzerComponent::paintScope(juce::Graphics& g, juce::Rectangle<float> area)
+{
+    g.setColour(juce::Colours::white.withAlpha(0.15f));
+    g.drawHorizontalLine(juce::roundToInt(area.getCentreY()), area.getX(), area.getRight());
+
+    juce::Path path;
+    const float halfHeight = area.getHeight() * 0.5f;
+
+    for (int i = 0; i < SpectrumAnalyzer::scopeSize; ++i)
+    {
+        const juce::Point<float> point(area.getX() + area.getWidth() * (float) i / (float) (SpectrumAnalyzer::scopeSize - 1),
+                                       area.getCentreY() - halfHeight * juce::jlimit(-1.0f, 1.0f, frame.scope[(size_t) i]));
+        if (i == 0)
+            path.startNewSubPath(point);
+        else
+            path.lineTo(point);
+    }
+
+    g.setColour(juce::Colours::skyblue);
+    g.strokePath(path, juce::PathStrokeType(1.0f));
+}
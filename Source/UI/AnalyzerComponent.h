@@ -0,0 +1,32 @@
+#pragma once
+#include <JuceHeader.h>
+#include "../Audio/SpectrumAnalyzer.h"
+
+class AudioEngine;
+
+// Spectrum (smoothed, with peak-hold) and oscilloscope of the engine output.
+// Shown on its own for plugins without an editor, or as a translucent overlay
+// on top of an editor. Analysis runs on the SpectrumAnalyzer thread while the
+// component exists; painting is throttled to a fixed frame rate.
+class AnalyzerComponent : public juce::Component,
+                          private juce::Timer
+{
+public:
+    static constexpr int frameRateHz = 30;
+
+    AnalyzerComponent(AudioEngine& engine, bool drawAsOverlay);
+    ~AnalyzerComponent() override;
+
+    void paint(juce::Graphics& g) override;
+
+private:
+    void timerCallback() override;
+    void paintSpectrum(juce::Graphics& g, juce::Rectangle<float> area);
+    void paintScope(juce::Graphics& g, juce::Rectangle<float> area);
+
+    SpectrumAnalyzer analyzer;
+    SpectrumAnalyzer::Frame frame;
+    bool isOverlay{false};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnalyzerComponent)
+};